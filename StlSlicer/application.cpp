@@ -3,6 +3,9 @@
 #include <vector>
 #include <algorithm>
 
+static constexpr UINT_PTR s_loadTimerId = 1;
+static constexpr UINT s_loadTimerInterval = 100;
+
 void Application::PaintEvent()
 {
 	m_graphics.BeginDraw();
@@ -25,13 +28,20 @@ void Application::PaintEvent()
 		shaderData.ambient = 1.0f;
 		m_graphics.RenderPlain(shaderData);
 
-		for (std::size_t i = 1; i < m_slice.size(); i += 2)
+		const float scale = min(static_cast<float>(m_resolution.x) * 0.5f, static_cast<float>(m_resolution.y));
+		const mth::float2 offset = mth::float2(static_cast<float>(m_resolution.x) * 0.75f, static_cast<float>(m_resolution.y) * 0.5f);
+		for (std::size_t c = 0; c < m_contours.ContourCount(); ++c)
 		{
-			const float scale = min(static_cast<float>(m_resolution.x) * 0.5f, static_cast<float>(m_resolution.y));
-			const mth::float2 offset = mth::float2(static_cast<float>(m_resolution.x) * 0.75f, static_cast<float>(m_resolution.y) * 0.5f);
-			const mth::float2 p1 = offset + m_slice[i - 1] * scale;
-			const mth::float2 p2 = offset + m_slice[i - 0] * scale;
-			m_graphics.Context2D()->DrawLine(D2D1::Point2F(p1.x, p1.y), D2D1::Point2F(p2.x, p2.y), m_brush.Get(), 2.0f);
+			// open contours mean holes in the mesh, they are drawn in a different color
+			const std::span<const mth::float2> contour = m_contours.Contour(c);
+			ID2D1SolidColorBrush* brush = m_contours.closed[c] ? m_brush.Get() : m_openBrush.Get();
+			const std::size_t lineCount = m_contours.closed[c] ? contour.size() : contour.size() - 1;
+			for (std::size_t i = 0; i < lineCount; ++i)
+			{
+				const mth::float2 p1 = offset + contour[i] * scale;
+				const mth::float2 p2 = offset + contour[(i + 1) % contour.size()] * scale;
+				m_graphics.Context2D()->DrawLine(D2D1::Point2F(p1.x, p1.y), D2D1::Point2F(p2.x, p2.y), brush, 2.0f);
+			}
 		}
 	}
 
@@ -50,22 +60,50 @@ void Application::DropFileEvent(HDROP drop)
 {
 	WCHAR filename[MAX_PATH + 1]{};
 	DragQueryFile(drop, 0, filename, MAX_PATH);
+	DragFinish(drop);
+
+	m_loadJob.reset();	// a newer drop cancels the load still running
+	m_loadJob = std::make_unique<LoadJob>(filename);
+	SetTimer(m_mainWindow, s_loadTimerId, s_loadTimerInterval, nullptr);
+	SetForegroundWindow(m_mainWindow);
+}
+
+void Application::LoadTimerEvent()
+{
+	const LoadJob::State state = m_loadJob ? m_loadJob->Poll() : LoadJob::State::Cancelled;
+	if (LoadJob::State::Running == state)
+	{
+		const int percent = static_cast<int>(m_loadJob->Progress().Fraction() * 100.0f);
+		SetWindowTextW(m_mainWindow, (m_title + L" - loading " + std::to_wstring(percent) + L"% (Esc to cancel)").c_str());
+		return;
+	}
+
+	KillTimer(m_mainWindow, s_loadTimerId);
+	SetWindowTextW(m_mainWindow, m_title.c_str());
+	if (!m_loadJob)
+		return;
+
 	try
 	{
-		if (m_model.Load(filename))
+		if (LoadJob::State::Succeeded == state)
 		{
-			m_graphics.LoadModel(m_model.Vertices().data(), static_cast<unsigned>(m_model.Vertices().size()));
+			Model model = m_loadJob->TakeModel();
+			m_graphics.LoadModel(model.Mesh());
+			m_model = std::move(model);
 			SetViewForModel();
 			InvalidateRect(m_mainWindow, nullptr, false);
 		}
+		else if (!m_loadJob->Error().empty())
+		{
+			throw std::runtime_error(m_loadJob->Error());
+		}
 	}
 	catch (const std::exception& ex)
 	{
 		OutputDebugStringA(ex.what());
 		MessageBoxA(nullptr, ex.what(), "Error", MB_OK);
 	}
-	DragFinish(drop);
-	SetForegroundWindow(m_mainWindow);
+	m_loadJob.reset();
 }
 
 void Application::MouseLButtonDownEvent(int x, int y, WPARAM flags)
@@ -148,6 +186,10 @@ void Application::KeyDownEvent(WPARAM key)
 		m_plainShowing = !m_plainShowing;
 		InvalidateRect(m_mainWindow, nullptr, false);
 	}
+	else if (VK_ESCAPE == key && m_loadJob)
+	{
+		m_loadJob->Cancel();
+	}
 }
 
 void Application::KeyUpEvent(WPARAM key)
@@ -161,6 +203,7 @@ void Application::SetViewForModel()
 	m_cameraDistance = 2.0f;
 	m_plainRotation = mth::float3x3::Identity();
 	m_plainOffset = 0.0f;
+	m_sliceSession = std::make_unique<SliceSession>(m_model.Mesh(), m_model.SliceIndices());	// the mesh has just been replaced
 	CalcSlice();
 }
 
@@ -168,9 +211,14 @@ void Application::CalcSlice()
 {
 	const mth::float3 normal = m_plainRotation * mth::float3(0.0f, 1.0f, 0.0f);
 	const float distance = normal.Dot(m_plainOffset / m_modelScale + m_modelOffset);
-	m_slice = m_model.CalcSlice(normal, distance, m_processorCount);
+	// going back to a recent plane skips the session, which moves on from wherever it was left on the next miss
+	if (!m_model.Cache().Find(normal, distance, m_contours))
+	{
+		m_contours = m_sliceSession->CalcContours(normal, distance);
+		m_model.Cache().Insert(normal, distance, m_contours);
+	}
 
-	for (mth::float2& p : m_slice)
+	for (mth::float2& p : m_contours.points)
 	{
 		const mth::float3 offset = mth::float3x3::RotateUnitVector(normal, mth::float3(0.0f, 1.0f, 0.0f)) * m_modelOffset;
 		p.x -= offset.x;
@@ -184,8 +232,7 @@ Application::Application()
 	, m_prevCursor{}
 	, m_cameraDistance{}
 	, m_modelScale{}
-	, m_plainShowing{ true }
-	, m_processorCount{} {}
+	, m_plainShowing{ true } {}
 
 Application::~Application()
 {
@@ -201,6 +248,7 @@ void Application::Init(const wchar_t* title, int width, int height)
 	wc.style = CS_HREDRAW | CS_VREDRAW;
 	wc.lpfnWndProc = DefWindowProcW;
 	RegisterClassExW(&wc);
+	m_title = title;
 	RECT rect{ 0, 0, width, height };
 	AdjustWindowRectEx(&rect, WS_OVERLAPPEDWINDOW, false, 0);
 	m_resolution.x = rect.right - rect.left;
@@ -212,15 +260,12 @@ void Application::Init(const wchar_t* title, int width, int height)
 			return reinterpret_cast<Application*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA))->MessageHandler(msg, wparam, lparam);
 		})));
 
-	SYSTEM_INFO sysinfo;
-	GetSystemInfo(&sysinfo);
-	m_processorCount = sysinfo.dwNumberOfProcessors;
-
 	m_graphics.Init(m_mainWindow);
 	m_model.Cube();
 	SetViewForModel();
-	m_graphics.LoadModel(m_model.Vertices().data(), static_cast<unsigned>(m_model.Vertices().size()));
+	m_graphics.LoadModel(m_model.Mesh());
 	m_brush = m_graphics.CreateBrush(mth::float4(1.0f, 1.0f, 1.0f, 1.0f));
+	m_openBrush = m_graphics.CreateBrush(mth::float4(1.0f, 0.3f, 0.3f, 1.0f));
 
 	ShowWindow(m_mainWindow, SW_SHOWDEFAULT);
 	UpdateWindow(m_mainWindow);
@@ -273,6 +318,10 @@ LRESULT Application::MessageHandler(UINT msg, WPARAM wparam, LPARAM lparam)
 	case WM_DROPFILES:
 		DropFileEvent(reinterpret_cast<HDROP>(wparam));
 		return 0;
+	case WM_TIMER:
+		if (s_loadTimerId == wparam)
+			LoadTimerEvent();
+		return 0;
 	case WM_DESTROY:
 		PostQuitMessage(0);
 		return 0;
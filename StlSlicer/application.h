@@ -2,10 +2,15 @@
 
 #include "graphics.h"
 #include "model.h"
+#include "slicesession.h"
+#include "loadjob.h"
+#include <memory>
+#include <string>
 
 class Application
 {
 	HWND m_mainWindow;
+	std::wstring m_title;
 	POINT m_prevCursor;
 	mth::vec2<int> m_resolution;
 	Graphics m_graphics;
@@ -18,14 +23,17 @@ class Application
 	mth::float3x3 m_plainRotation;
 	mth::float3 m_plainOffset;
 	bool m_plainShowing;
-	std::vector<mth::float2> m_slice;
+	std::unique_ptr<SliceSession> m_sliceSession;
+	ContourSet m_contours;
 	ComPtr<ID2D1SolidColorBrush> m_brush;
-	int m_processorCount;
+	ComPtr<ID2D1SolidColorBrush> m_openBrush;
+	std::unique_ptr<LoadJob> m_loadJob;
 
 private:
 	void PaintEvent();
 	void Resize(int width, int height);
 	void DropFileEvent(HDROP drop);
+	void LoadTimerEvent();
 	void MouseLButtonDownEvent(int x, int y, WPARAM flags);
 	void MouseRButtonDownEvent(int x, int y, WPARAM flags);
 	void MouseLButtonUpEvent(int x, int y, WPARAM flags);
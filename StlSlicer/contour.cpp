@@ -0,0 +1,200 @@
+#include "contour.h"
+#include "slicekernel.h"
+#include "gridmesh.h"
+#include <algorithm>
+#include <limits>
+
+static constexpr std::uint32_t s_noEnd = std::numeric_limits<std::uint32_t>::max();
+static constexpr std::uint64_t s_noEdge = std::numeric_limits<std::uint64_t>::max();
+
+static inline std::uint64_t EdgeHash(std::uint64_t edge)
+{
+	edge ^= edge >> 33;
+	edge *= 0xff51afd7ed558ccdull;
+	edge ^= edge >> 33;
+	return edge;
+}
+
+// The end shared with every segment end, end 2 * s is the first point of segment s and 2 * s + 1 the second.
+// Edges touched by more than two ends pair them up in order, so every end has at most one partner.
+template <typename Segment>
+static std::vector<std::uint32_t> PartnerEnds(const std::vector<Segment>& segments)
+{
+	struct Slot
+	{
+		std::uint64_t edge;
+		std::uint32_t end;
+	};
+
+	const std::size_t endCount = 2 * segments.size();
+	std::size_t capacity = 16;
+	while (capacity < 2 * endCount)
+		capacity *= 2;
+	std::vector<Slot> slots(capacity, { s_noEdge, s_noEnd });
+	std::vector<std::uint32_t> partners(endCount, s_noEnd);
+
+	for (std::uint32_t end = 0; end < endCount; ++end)
+	{
+		const std::uint64_t edge = segments[end / 2].edges[end % 2];
+		for (std::size_t slot = EdgeHash(edge) & (capacity - 1);; slot = (slot + 1) & (capacity - 1))
+		{
+			if (s_noEdge == slots[slot].edge)
+			{
+				slots[slot] = { edge, end };
+				break;
+			}
+			if (edge == slots[slot].edge)
+			{
+				if (s_noEnd == slots[slot].end)
+				{
+					slots[slot].end = end;
+				}
+				else
+				{
+					partners[end] = slots[slot].end;
+					partners[slots[slot].end] = end;
+					slots[slot].end = s_noEnd;
+				}
+				break;
+			}
+		}
+	}
+	return partners;
+}
+
+std::uint64_t EdgeKey(std::uint32_t vertex0, std::uint32_t vertex1)
+{
+	return static_cast<std::uint64_t>(std::min(vertex0, vertex1)) << 32 | std::max(vertex0, vertex1);
+}
+
+bool CalculateEdgeSegment(EdgeSegment& segment, const IndexedMesh& mesh, std::size_t triangle, const mth::float3x3& plainTransform, float plainDistFromOrigin)
+{
+	const std::uint32_t* vertices = &mesh.indices[3 * triangle];
+	const mth::float3 v[] = {
+		PlainFramePoint(plainTransform, plainDistFromOrigin, mesh.positions[vertices[0]]),
+		PlainFramePoint(plainTransform, plainDistFromOrigin, mesh.positions[vertices[1]]),
+		PlainFramePoint(plainTransform, plainDistFromOrigin, mesh.positions[vertices[2]]) };
+
+	// every edge is cut from its smaller vertex, so both triangles on it get bitwise the same point
+	int count = 0;
+	for (int edge = 0; edge < 3; ++edge)
+	{
+		const int a = edge, b = (edge + 1) % 3;
+		if (!(v[a].y * v[b].y < 0.0f))
+			continue;
+		if (2 == count)
+			return false;
+		segment.points[count] = vertices[a] < vertices[b] ? PlainEdgeCrossing(v[a], v[b]) : PlainEdgeCrossing(v[b], v[a]);
+		segment.edges[count] = EdgeKey(vertices[a], vertices[b]);
+		++count;
+	}
+	if (2 != count)	// a NaN corner can leave a single crossing
+		return false;
+
+	// the outward facing normal of the triangle has to be on the right of the segment
+	const mth::float3& p0 = mesh.positions[vertices[0]];
+	const mth::float3& p1 = mesh.positions[vertices[1]];
+	const mth::float3& p2 = mesh.positions[vertices[2]];
+	const mth::float3 normal = plainTransform * (p1 - p0).Cross(p2 - p0);
+	const mth::float2 direction = segment.points[1] - segment.points[0];
+	if (direction.y * normal.x - direction.x * normal.z < 0.0f)
+	{
+		std::swap(segment.points[0], segment.points[1]);
+		std::swap(segment.edges[0], segment.edges[1]);
+	}
+	return true;
+}
+
+// Walks the paired segment ends into contours, pointOf(end) is the point the end lies on.
+template <typename Point, typename PointOf>
+static BasicContourSet<Point> JoinPartnerEnds(const std::vector<std::uint32_t>& partners, PointOf pointOf)
+{
+	const std::size_t segmentCount = partners.size() / 2;
+	BasicContourSet<Point> contours;
+	contours.contourOffsets.push_back(0);
+	contours.points.reserve(segmentCount + 1);
+
+	std::vector<bool> used(segmentCount);
+	std::vector<std::uint32_t> chain;	// entry ends in walking order
+
+	for (std::uint32_t start = 0; start < segmentCount; ++start)
+	{
+		if (used[start])
+			continue;
+
+		// walk backwards to the start of an open chain, or once around a loop
+		std::uint32_t first = 2 * start;
+		while (true)
+		{
+			const std::uint32_t previous = partners[first];
+			if (s_noEnd == previous || previous / 2 == start)
+				break;
+			first = previous ^ 1;
+		}
+
+		chain.clear();
+		bool closed = false;
+		for (std::uint32_t entry = first;;)
+		{
+			used[entry / 2] = true;
+			chain.push_back(entry);
+			const std::uint32_t next = partners[entry ^ 1];
+			if (s_noEnd == next)
+				break;
+			if (used[next / 2])
+			{
+				closed = next == first;
+				break;
+			}
+			entry = next;
+		}
+
+		// walk the way most segments point, those follow the orientation of the mesh
+		const std::size_t forward = std::count_if(chain.begin(), chain.end(), [](std::uint32_t entry) { return 0 == entry % 2; });
+		if (2 * forward < chain.size())
+		{
+			std::reverse(chain.begin(), chain.end());
+			for (std::uint32_t& entry : chain)
+				entry ^= 1;
+		}
+
+		for (std::uint32_t entry : chain)
+			contours.points.push_back(pointOf(entry));
+		if (!closed)
+			contours.points.push_back(pointOf(chain.back() ^ 1));
+		contours.contourOffsets.push_back(contours.points.size());
+		contours.closed.push_back(closed);
+	}
+	return contours;
+}
+
+template <typename Point>
+BasicContourSet<Point> JoinSegments(const std::vector<BasicEdgeSegment<Point>>& segments)
+{
+	return JoinPartnerEnds<Point>(PartnerEnds(segments), [&segments](std::uint32_t end) { return segments[end / 2].points[end % 2]; });
+}
+
+ContourSet JoinNumberedSegments(std::span<const mth::float2> points, std::span<const std::uint32_t> endPoints)
+{
+	// every point holds the end waiting for a partner, a point with more than two ends pairs them up in order like PartnerEnds
+	std::vector<std::uint32_t> waiting(points.size(), s_noEnd);
+	std::vector<std::uint32_t> partners(endPoints.size(), s_noEnd);
+	for (std::uint32_t end = 0; end < endPoints.size(); ++end)
+	{
+		std::uint32_t& other = waiting[endPoints[end]];
+		if (s_noEnd == other)
+		{
+			other = end;
+		}
+		else
+		{
+			partners[end] = other;
+			partners[other] = end;
+			other = s_noEnd;
+		}
+	}
+	return JoinPartnerEnds<mth::float2>(partners, [points, endPoints](std::uint32_t end) { return points[endPoints[end]]; });
+}
+
+template ContourSet JoinSegments(const std::vector<EdgeSegment>& segments);
+template GridContourSet JoinSegments(const std::vector<GridSegment>& segments);
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "mesh.h"
+#include <vector>
+#include <span>
+#include <cstdint>
+
+// A slice segment whose ends lie on mesh edges. An edge is the pair of its vertex indices, smaller first, packed into 64 bits.
+// The segment runs with the outside of the solid on its right.
+template <typename Point>
+struct BasicEdgeSegment
+{
+	Point points[2];
+	std::uint64_t edges[2];
+};
+using EdgeSegment = BasicEdgeSegment<mth::float2>;
+
+// Contour i owns points [contourOffsets[i], contourOffsets[i + 1]), closed contours do not repeat their first point.
+// On a closed, consistently oriented mesh outer contours run counter-clockwise and holes clockwise.
+template <typename Point>
+struct BasicContourSet
+{
+	std::vector<Point> points;
+	std::vector<std::size_t> contourOffsets;
+	std::vector<bool> closed;
+
+	inline std::size_t ContourCount() const { return closed.size(); }
+	inline std::span<const Point> Contour(std::size_t contour) const { return { points.data() + contourOffsets[contour], points.data() + contourOffsets[contour + 1] }; }
+};
+using ContourSet = BasicContourSet<mth::float2>;
+
+std::uint64_t EdgeKey(std::uint32_t vertex0, std::uint32_t vertex1);
+// Cuts one triangle of the mesh like CalculateTriangleSegment and orients the segment by the winding of the triangle.
+// Edges are cut from their smaller vertex, so neighbouring triangles share their end points exactly.
+bool CalculateEdgeSegment(EdgeSegment& segment, const IndexedMesh& mesh, std::size_t triangle, const mth::float3x3& plainTransform, float plainDistFromOrigin);
+// Chains the segments through their shared edges in time linear in the number of segments.
+// Segments of a non-manifold or open mesh that cannot be closed end up in open contours.
+// Instantiated for float and grid points.
+template <typename Point>
+BasicContourSet<Point> JoinSegments(const std::vector<BasicEdgeSegment<Point>>& segments);
+// The same chaining for segments that refer to numbered points, segment i runs from points[endPoints[2 * i]] to points[endPoints[2 * i + 1]].
+// Ends on the same point are joined through an array indexed by the point, without hashing.
+ContourSet JoinNumberedSegments(std::span<const mth::float2> points, std::span<const std::uint32_t> endPoints);
\ No newline at end of file
@@ -0,0 +1,569 @@
+#include "contourboolean.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <set>
+#include <cmath>
+#include <cstdlib>
+#include <atomic>
+
+// An edge between two grid points, left coming first in sweep order.
+struct SweepEdge
+{
+	GridPoint left;
+	GridPoint right;
+	int windingSteps[2];	// how the winding number of the subject and the clip changes from below the edge to above it
+	int aboveWindings[2];
+};
+
+static inline bool SamePoint(GridPoint a, GridPoint b)
+{
+	return a.x == b.x && a.y == b.y;
+}
+
+// Sweep order, by x and then by y. Vertical edges are swept from bottom to top as if the sweep line were tilted a little.
+static inline bool Before(GridPoint a, GridPoint b)
+{
+	return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+// sign of the cross product, the products of coordinate differences within the grid limit fit 64 bits
+static inline int CrossSign(GridPoint a, GridPoint b)
+{
+	const std::int64_t left = a.x * b.y;
+	const std::int64_t right = a.y * b.x;
+	return (left > right) - (left < right);
+}
+
+static inline GridPoint Difference(GridPoint to, GridPoint from)
+{
+	return { to.x - from.x, to.y - from.y };
+}
+
+// positive when r is left of the line from p to q
+static inline int Orientation(GridPoint p, GridPoint q, GridPoint r)
+{
+	return CrossSign(Difference(q, p), Difference(r, p));
+}
+
+// Whether edge a is below edge b where the sweep line crosses both. The edge that starts later is placed by its left end,
+// or by its right end when they start on the same point. Collinear edges are ordered by index.
+static bool Below(const std::vector<SweepEdge>& edges, std::uint32_t a, std::uint32_t b)
+{
+	if (a == b)
+		return false;
+	const bool aLater = Before(edges[b].left, edges[a].left);
+	const SweepEdge& later = edges[aLater ? a : b];
+	const SweepEdge& earlier = edges[aLater ? b : a];
+	int side = SamePoint(later.left, earlier.left) ? 0 : Orientation(earlier.left, earlier.right, later.left);
+	if (0 == side)
+		side = Orientation(earlier.left, earlier.right, later.right);
+	if (0 == side)
+		return a < b;
+	return aLater ? side < 0 : side > 0;
+}
+
+struct SweepOrder
+{
+	const std::vector<SweepEdge>* edges;
+
+	inline bool operator()(std::uint32_t a, std::uint32_t b) const { return Below(*edges, a, b); }
+};
+using ActiveEdges = std::set<std::uint32_t, SweepOrder>;
+
+struct SweepEvent
+{
+	GridPoint point;
+	std::uint32_t edge;
+	bool left;
+};
+
+// A signed 128 bit number, enough for the products of the exact rounding tests.
+struct Wide
+{
+	std::int64_t high;
+	std::uint64_t low;
+};
+
+static Wide Multiply(std::int64_t a, std::int64_t b)
+{
+	const bool negative = (a < 0) != (b < 0);
+	const std::uint64_t ua = a < 0 ? 0 - static_cast<std::uint64_t>(a) : static_cast<std::uint64_t>(a);
+	const std::uint64_t ub = b < 0 ? 0 - static_cast<std::uint64_t>(b) : static_cast<std::uint64_t>(b);
+	const std::uint64_t a0 = ua & 0xffffffff, a1 = ua >> 32, b0 = ub & 0xffffffff, b1 = ub >> 32;
+	const std::uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+	const std::uint64_t middle = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+	std::uint64_t low = (middle << 32) | (p00 & 0xffffffff);
+	std::uint64_t high = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+	if (negative)
+	{
+		low = ~low + 1;
+		high = ~high + (0 == low ? 1 : 0);
+	}
+	return { static_cast<std::int64_t>(high), low };
+}
+
+static inline bool Less(Wide a, Wide b)
+{
+	return a.high < b.high || (a.high == b.high && a.low < b.low);
+}
+
+static inline bool ProperlyCross(const SweepEdge& a, const SweepEdge& b)
+{
+	if (a.right.x < b.left.x || b.right.x < a.left.x ||
+		std::max(a.left.y, a.right.y) < std::min(b.left.y, b.right.y) || std::max(b.left.y, b.right.y) < std::min(a.left.y, a.right.y))
+		return false;
+	return Orientation(a.left, a.right, b.left) * Orientation(a.left, a.right, b.right) < 0 &&
+		Orientation(b.left, b.right, a.left) * Orientation(b.left, b.right, a.right) < 0;
+}
+
+// factor * num / den rounded half up, den positive: the k with (2k - 1) den <= 2 factor num < (2k + 1) den
+static std::int64_t RoundQuotient(std::int64_t factor, std::int64_t num, std::int64_t den)
+{
+	std::int64_t k = static_cast<std::int64_t>(std::floor(static_cast<double>(factor) * static_cast<double>(num) / static_cast<double>(den) + 0.5));
+	const Wide twice = Multiply(2 * factor, num);
+	while (Less(twice, Multiply(2 * k - 1, den)))
+		--k;
+	while (!Less(twice, Multiply(2 * k + 1, den)))
+		++k;
+	return k;
+}
+
+// The grid point whose pixel, the half open unit square around it, holds the crossing of two properly crossing edges.
+static GridPoint CrossingPixel(const SweepEdge& a, const SweepEdge& b)
+{
+	const GridPoint r = Difference(a.right, a.left), s = Difference(b.right, b.left), q = Difference(b.left, a.left);
+	// the products and their difference fit 64 bits as every coordinate is below the grid limit
+	std::int64_t den = r.x * s.y - r.y * s.x;
+	std::int64_t num = q.x * s.y - q.y * s.x;
+	if (den < 0)
+	{
+		den = -den;
+		num = -num;
+	}
+	return { a.left.x + RoundQuotient(r.x, num, den), a.left.y + RoundQuotient(r.y, num, den) };
+}
+
+// A parameter along an edge as num / den with a positive den, and whether a bound includes it.
+struct Bound
+{
+	std::int64_t num;
+	std::int64_t den;
+	bool closed;
+};
+
+static inline int Compare(Bound a, Bound b)
+{
+	const Wide left = Multiply(a.num, b.den), right = Multiply(b.num, a.den);
+	return Less(right, left) - Less(left, right);
+}
+
+// Narrows the parameter range to where from + t * delta lies in [centre - 1/2, centre + 1/2), false if no parameter does.
+static bool ClipToPixel(std::int64_t from, std::int64_t delta, std::int64_t centre, Bound& lower, Bound& upper)
+{
+	const std::int64_t offset = 2 * (centre - from);	// doubled, so the pixel sides are whole numbers
+	if (0 == delta)
+		return 0 == offset;
+	// offset - 1 <= 2 t delta < offset + 1
+	const Bound enter = delta > 0 ? Bound{ offset - 1, 2 * delta, true } : Bound{ -offset - 1, -2 * delta, false };
+	const Bound leave = delta > 0 ? Bound{ offset + 1, 2 * delta, false } : Bound{ 1 - offset, -2 * delta, true };
+	const int lowerOrder = Compare(enter, lower);
+	if (lowerOrder > 0 || (0 == lowerOrder && !enter.closed))
+		lower = enter;
+	const int upperOrder = Compare(leave, upper);
+	if (upperOrder < 0 || (0 == upperOrder && !leave.closed))
+		upper = leave;
+	return true;
+}
+
+static bool PassesPixel(const SweepEdge& edge, GridPoint centre)
+{
+	Bound lower{ 0, 1, true }, upper{ 1, 1, true };
+	if (!ClipToPixel(edge.left.x, edge.right.x - edge.left.x, centre.x, lower, upper) ||
+		!ClipToPixel(edge.left.y, edge.right.y - edge.left.y, centre.y, lower, upper))
+		return false;
+	const int order = Compare(lower, upper);
+	return order < 0 || (0 == order && lower.closed && upper.closed);
+}
+
+// An item registered in a cell of the uniform grid that limits the exact tests to what lies close.
+struct CellEntry
+{
+	std::uint64_t cell;
+	std::uint32_t item;
+};
+
+static inline bool operator<(const CellEntry& a, const CellEntry& b)
+{
+	return a.cell < b.cell || (a.cell == b.cell && a.item < b.item);
+}
+
+static inline std::uint64_t CellKey(std::int64_t column, std::int64_t row)
+{
+	// cells of grid points below the limit stay within 31 bits either way
+	return (static_cast<std::uint64_t>(column + (std::int64_t(1) << 31)) << 32) | static_cast<std::uint64_t>(row + (std::int64_t(1) << 31));
+}
+
+// cells about as wide as an average edge, so an edge covers a few of them and a cell holds a few edges
+static int CellShift(const std::vector<SweepEdge>& edges)
+{
+	double extent = 0.0;
+	for (const SweepEdge& edge : edges)
+		extent += static_cast<double>(std::max(edge.right.x - edge.left.x, std::abs(edge.right.y - edge.left.y)));
+	extent /= static_cast<double>(std::max<std::size_t>(edges.size(), 1));
+	int shift = 0;
+	while (shift < 31 && static_cast<double>(std::int64_t(1) << shift) < extent)
+		++shift;
+	return shift;
+}
+
+// Calls visit with every cell the edge passes, and maybe a few more next to them.
+template <typename Visit>
+static void VisitCells(const SweepEdge& edge, int shift, Visit visit)
+{
+	const double slope = edge.right.x != edge.left.x ? static_cast<double>(edge.right.y - edge.left.y) / static_cast<double>(edge.right.x - edge.left.x) : 0.0;
+	const std::int64_t lastColumn = edge.right.x >> shift;
+	for (std::int64_t column = edge.left.x >> shift; column <= lastColumn; ++column)
+	{
+		double fromY = static_cast<double>(edge.left.y), toY = static_cast<double>(edge.right.y);
+		if (edge.right.x != edge.left.x)
+		{
+			const std::int64_t fromX = std::max(edge.left.x, column << shift), toX = std::min(edge.right.x, (column + 1) << shift);
+			fromY = static_cast<double>(edge.left.y) + slope * static_cast<double>(fromX - edge.left.x);
+			toY = static_cast<double>(edge.left.y) + slope * static_cast<double>(toX - edge.left.x);
+		}
+		// a unit more covers the rounding
+		const std::int64_t firstRow = (static_cast<std::int64_t>(std::floor(std::min(fromY, toY))) - 1) >> shift;
+		const std::int64_t lastRow = (static_cast<std::int64_t>(std::ceil(std::max(fromY, toY))) + 1) >> shift;
+		for (std::int64_t row = firstRow; row <= lastRow; ++row)
+			visit(CellKey(column, row));
+	}
+}
+
+// Snap rounding: every end point and the pixel of every crossing is a hot pixel, and each edge is replaced by the path
+// through the centres of the hot pixels it passes. Rounded so, the fragments meet only in their ends or lie on each other,
+// where the sweep of the boundary needs them apart or equal.
+static std::vector<SweepEdge> SnapRound(const std::vector<SweepEdge>& edges)
+{
+	const int shift = CellShift(edges);
+	std::vector<CellEntry> edgeCells;
+	for (std::uint32_t i = 0; i < edges.size(); ++i)
+		VisitCells(edges[i], shift, [&edgeCells, i](std::uint64_t cell) { edgeCells.push_back({ cell, i }); });
+	std::sort(edgeCells.begin(), edgeCells.end());
+
+	std::vector<GridPoint> hotPixels;
+	hotPixels.reserve(2 * edges.size());
+	for (const SweepEdge& edge : edges)
+	{
+		hotPixels.push_back(edge.left);
+		hotPixels.push_back(edge.right);
+	}
+	// edges crossing in a cell are both in it, a pair sharing several cells adds its crossing more than once
+	for (std::size_t first = 0; first < edgeCells.size();)
+	{
+		std::size_t last = first + 1;
+		while (last < edgeCells.size() && edgeCells[last].cell == edgeCells[first].cell)
+			++last;
+		for (std::size_t a = first; a < last; ++a)
+			for (std::size_t b = a + 1; b < last; ++b)
+				if (ProperlyCross(edges[edgeCells[a].item], edges[edgeCells[b].item]))
+					hotPixels.push_back(CrossingPixel(edges[edgeCells[a].item], edges[edgeCells[b].item]));
+		first = last;
+	}
+	std::sort(hotPixels.begin(), hotPixels.end(), Before);
+	hotPixels.erase(std::unique(hotPixels.begin(), hotPixels.end(), SamePoint), hotPixels.end());
+
+	// a pixel goes to every cell it overlaps, so an edge finds it in whichever cell the edge meets it
+	std::vector<CellEntry> pixelCells;
+	pixelCells.reserve(hotPixels.size());
+	for (std::uint32_t i = 0; i < hotPixels.size(); ++i)
+	{
+		const GridPoint pixel = hotPixels[i];
+		for (std::int64_t column = (pixel.x - 1) >> shift; column <= pixel.x >> shift; ++column)
+			for (std::int64_t row = (pixel.y - 1) >> shift; row <= pixel.y >> shift; ++row)
+				pixelCells.push_back({ CellKey(column, row), i });
+	}
+	std::sort(pixelCells.begin(), pixelCells.end());
+
+	std::vector<SweepEdge> fragments;
+	fragments.reserve(edges.size());
+	std::vector<std::uint32_t> nearby;
+	std::vector<GridPoint> path;
+	for (const SweepEdge& edge : edges)
+	{
+		nearby.clear();
+		VisitCells(edge, shift, [&](std::uint64_t cell) {
+			auto found = std::lower_bound(pixelCells.begin(), pixelCells.end(), CellEntry{ cell, 0 });
+			for (; found != pixelCells.end() && found->cell == cell; ++found)
+				nearby.push_back(found->item);
+			});
+		std::sort(nearby.begin(), nearby.end());
+		nearby.erase(std::unique(nearby.begin(), nearby.end()), nearby.end());
+
+		path.clear();
+		for (std::uint32_t pixel : nearby)
+			if (PassesPixel(edge, hotPixels[pixel]))
+				path.push_back(hotPixels[pixel]);
+		// the pixels an edge passes rise or fall together with it
+		const bool rising = edge.right.y >= edge.left.y;
+		const auto along = [rising](GridPoint a, GridPoint b) { return a.x < b.x || (a.x == b.x && (rising ? a.y < b.y : a.y > b.y)); };
+		std::sort(path.begin(), path.end(), along);
+
+		// a centre that happens to lie on a fragment without its pixel being passed still splits it
+		const std::size_t passed = path.size();
+		for (std::size_t i = 1; i < passed; ++i)
+			for (std::uint32_t pixel : nearby)
+			{
+				const GridPoint centre = hotPixels[pixel];
+				if (0 == Orientation(path[i - 1], path[i], centre) && along(path[i - 1], centre) && along(centre, path[i]))
+					path.push_back(centre);
+			}
+		if (path.size() != passed)
+			std::sort(path.begin(), path.end(), along);
+
+		for (std::size_t i = 1; i < path.size(); ++i)
+		{
+			SweepEdge fragment{ path[i - 1], path[i], { edge.windingSteps[0], edge.windingSteps[1] }, {} };
+			if (Before(fragment.right, fragment.left))
+			{
+				std::swap(fragment.left, fragment.right);
+				fragment.windingSteps[0] = -fragment.windingSteps[0];
+				fragment.windingSteps[1] = -fragment.windingSteps[1];
+			}
+			fragments.push_back(fragment);
+		}
+	}
+	return fragments;
+}
+
+// false if a point is not below the grid limit
+static bool AddContours(std::vector<SweepEdge>& edges, const GridContourSet& contours, int operand)
+{
+	for (std::size_t contour = 0; contour < contours.ContourCount(); ++contour)
+	{
+		if (!contours.closed[contour])
+			continue;
+		const std::span<const GridPoint> points = contours.Contour(contour);
+		for (std::size_t i = 0; i < points.size(); ++i)
+		{
+			const GridPoint from = points[i], to = points[(i + 1) % points.size()];
+			if (!(std::abs(from.x) < GridMesh::CoordinateLimit && std::abs(from.y) < GridMesh::CoordinateLimit))
+				return false;
+			if (SamePoint(from, to))
+				continue;
+			// walking the edge left to right, the winding number of a counter-clockwise contour grows above it
+			SweepEdge edge{ from, to, {}, {} };
+			edge.windingSteps[operand] = 1;
+			if (Before(to, from))
+			{
+				std::swap(edge.left, edge.right);
+				edge.windingSteps[operand] = -1;
+			}
+			edges.push_back(edge);
+		}
+	}
+	return true;
+}
+
+// Merges edges with the same ends into one, dropping those whose windings cancel out.
+static void MergeEqualEdges(std::vector<SweepEdge>& edges)
+{
+	std::sort(edges.begin(), edges.end(), [](const SweepEdge& a, const SweepEdge& b) {
+		return Before(a.left, b.left) || (SamePoint(a.left, b.left) && Before(a.right, b.right));
+		});
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < edges.size();)
+	{
+		SweepEdge merged = edges[i];
+		for (++i; i < edges.size() && SamePoint(edges[i].left, merged.left) && SamePoint(edges[i].right, merged.right); ++i)
+		{
+			merged.windingSteps[0] += edges[i].windingSteps[0];
+			merged.windingSteps[1] += edges[i].windingSteps[1];
+		}
+		if (0 != merged.windingSteps[0] || 0 != merged.windingSteps[1])
+			edges[count++] = merged;
+	}
+	edges.resize(count);
+}
+
+static inline bool Inside(BooleanOperation operation, const int windings[2])
+{
+	const bool subject = windings[0] > 0;
+	const bool clip = windings[1] > 0;
+	switch (operation)
+	{
+	case BooleanOperation::Union: return subject || clip;
+	case BooleanOperation::Intersection: return subject && clip;
+	default: return subject && !clip;
+	}
+}
+
+struct DirectedEdge
+{
+	GridPoint from;
+	GridPoint to;
+};
+
+// Sweeps the split edges bottom to top, every edge takes the windings below it from the one under it.
+// The edges with the inside of the result on one side only are its boundary, directed with the inside on their left.
+static std::vector<DirectedEdge> BoundaryEdges(std::vector<SweepEdge>& edges, BooleanOperation operation)
+{
+	std::vector<SweepEvent> events;
+	events.reserve(2 * edges.size());
+	for (std::uint32_t i = 0; i < edges.size(); ++i)
+	{
+		events.push_back({ edges[i].left, i, true });
+		events.push_back({ edges[i].right, i, false });
+	}
+	// edges starting on the same point go in from the bottom up, so each finds its lower neighbour already in place
+	std::sort(events.begin(), events.end(), [&edges](const SweepEvent& a, const SweepEvent& b) {
+		if (!SamePoint(a.point, b.point))
+			return Before(a.point, b.point);
+		if (a.left != b.left)
+			return b.left;
+		return a.left ? Below(edges, a.edge, b.edge) : a.edge < b.edge;
+		});
+
+	std::vector<DirectedEdge> boundary;
+	ActiveEdges active(SweepOrder{ &edges });
+	std::vector<ActiveEdges::iterator> positions(edges.size());
+	for (const SweepEvent& event : events)
+	{
+		if (!event.left)
+		{
+			active.erase(positions[event.edge]);
+			continue;
+		}
+		const ActiveEdges::iterator position = active.insert(event.edge).first;
+		positions[event.edge] = position;
+		SweepEdge& edge = edges[event.edge];
+		int belowWindings[2] = {};
+		if (position != active.begin())
+			std::copy_n(edges[*std::prev(position)].aboveWindings, 2, belowWindings);
+		for (int operand = 0; operand < 2; ++operand)
+			edge.aboveWindings[operand] = belowWindings[operand] + edge.windingSteps[operand];
+		const bool insideAbove = Inside(operation, edge.aboveWindings);
+		if (insideAbove != Inside(operation, belowWindings))
+			boundary.push_back(insideAbove ? DirectedEdge{ edge.left, edge.right } : DirectedEdge{ edge.right, edge.left });
+	}
+	return boundary;
+}
+
+// Rank of the counter-clockwise angle from reference to direction in (0, 2 pi], by half turns.
+static inline int TurnClass(GridPoint reference, GridPoint direction)
+{
+	const int side = CrossSign(reference, direction);
+	if (0 != side)
+		return side > 0 ? 0 : 2;
+	// parallel, the signs of one non-zero coordinate tell if they point the same way
+	const bool same = 0 != reference.x ? (reference.x > 0) == (direction.x > 0) : (reference.y > 0) == (direction.y > 0);
+	return same ? 3 : 1;
+}
+
+// whether leaving along a turns further right than leaving along b after arriving along incoming
+static inline bool SharperRightTurn(GridPoint incoming, GridPoint a, GridPoint b)
+{
+	const GridPoint back{ -incoming.x, -incoming.y };
+	const int classA = TurnClass(back, a);
+	const int classB = TurnClass(back, b);
+	if (classA != classB)
+		return classA < classB;
+	return (0 == classA || 2 == classA) && CrossSign(a, b) > 0;
+}
+
+// true if b lies on the segment between a and c
+static inline bool Straight(GridPoint a, GridPoint b, GridPoint c)
+{
+	if (0 != Orientation(a, b, c))
+		return false;
+	const GridPoint first = Difference(b, a), second = Difference(c, b);
+	return 0 != first.x ? (first.x > 0) == (second.x > 0) : (first.y > 0) == (second.y > 0);
+}
+
+// Chains the boundary edges into loops. Where several loops touch in a point the sharpest right turn is taken, which keeps them apart.
+// False if a chain cannot be closed, which only happens if edges cross or run through a point without ending there.
+static bool JoinBoundary(std::vector<DirectedEdge>& boundary, GridContourSet& contours)
+{
+	std::sort(boundary.begin(), boundary.end(), [](const DirectedEdge& a, const DirectedEdge& b) { return Before(a.from, b.from); });
+	std::vector<bool> used(boundary.size());
+	auto leaving = [&boundary](GridPoint point) {
+		return std::equal_range(boundary.begin(), boundary.end(), DirectedEdge{ point, point }, [](const DirectedEdge& a, const DirectedEdge& b) { return Before(a.from, b.from); });
+	};
+
+	contours = GridContourSet();
+	contours.contourOffsets.push_back(0);
+	std::vector<GridPoint> loop;
+	for (std::size_t start = 0; start < boundary.size(); ++start)
+	{
+		if (used[start])
+			continue;
+		loop.clear();
+		for (std::size_t edge = start;;)
+		{
+			used[edge] = true;
+			loop.push_back(boundary[edge].from);
+			const GridPoint end = boundary[edge].to;
+			if (SamePoint(end, boundary[start].from))
+				break;
+			const GridPoint incoming = Difference(end, boundary[edge].from);
+			std::size_t next = boundary.size();
+			const auto [first, last] = leaving(end);
+			for (auto candidate = first; candidate != last; ++candidate)
+			{
+				const std::size_t index = static_cast<std::size_t>(candidate - boundary.begin());
+				if (!used[index] && (boundary.size() == next ||
+					SharperRightTurn(incoming, Difference(candidate->to, candidate->from), Difference(boundary[next].to, boundary[next].from))))
+					next = index;
+			}
+			if (boundary.size() == next)
+				return false;
+			edge = next;
+		}
+
+		// the fragments leave points in the middle of straight runs
+		const std::size_t first = contours.points.size();
+		for (GridPoint point : loop)
+		{
+			while (contours.points.size() - first >= 2 && Straight(contours.points.end()[-2], contours.points.back(), point))
+				contours.points.pop_back();
+			contours.points.push_back(point);
+		}
+		while (contours.points.size() - first >= 3 && Straight(contours.points.end()[-2], contours.points.back(), contours.points[first]))
+			contours.points.pop_back();
+		std::size_t skipped = 0;
+		while (contours.points.size() - first - skipped >= 3 && Straight(contours.points.back(), contours.points[first + skipped], contours.points[first + skipped + 1]))
+			++skipped;
+		contours.points.erase(contours.points.begin() + first, contours.points.begin() + first + skipped);
+		if (contours.points.size() - first < 3)
+		{
+			contours.points.resize(first);
+			continue;
+		}
+		contours.contourOffsets.push_back(contours.points.size());
+		contours.closed.push_back(true);
+	}
+	return true;
+}
+
+bool CombineContours(const GridContourSet& subject, const GridContourSet& clip, BooleanOperation operation, GridContourSet& result)
+{
+	std::vector<SweepEdge> edges;
+	if (!AddContours(edges, subject, 0) || !AddContours(edges, clip, 1))
+		return false;
+	MergeEqualEdges(edges);
+	std::vector<SweepEdge> fragments = SnapRound(edges);
+	MergeEqualEdges(fragments);
+	std::vector<DirectedEdge> boundary = BoundaryEdges(fragments, operation);
+	return JoinBoundary(boundary, result);
+}
+
+bool CombineLayers(std::span<const GridContourSet> subjects, std::span<const GridContourSet> clips, BooleanOperation operation, std::vector<GridContourSet>& results)
+{
+	results.assign(subjects.size(), GridContourSet());
+	const GridContourSet noClip;
+	std::atomic<bool> combined = true;
+	ThreadPool::Shared().ParallelFor(subjects.size(), [&](std::size_t layer) {
+		if (!CombineContours(subjects[layer], layer < clips.size() ? clips[layer] : noClip, operation, results[layer]))
+			combined = false;
+		});
+	return combined;
+}
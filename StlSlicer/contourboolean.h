@@ -0,0 +1,26 @@
+#pragma once
+
+#include "gridmesh.h"
+#include <vector>
+#include <span>
+
+enum class BooleanOperation
+{
+	Union,
+	Intersection,
+	Difference	// subject minus clip
+};
+
+// Combines the closed contours of two grid slices, open contours are ignored.
+// A point is inside a slice where its contours wind around it a positive number of times, so overlapping shells
+// and contours repeated in one slice count once, which makes a union with an empty clip merge a raw slice.
+// The result runs outer contours counter-clockwise and holes clockwise without straight points, its contours touch at most in points.
+// Crossings are snap rounded to the grid, so the result can be off the exact one by half a grid step per axis.
+// Points have to lie strictly within GridMesh::CoordinateLimit of the origin, otherwise nothing is combined.
+// The crossings are found on a uniform grid of cells about as wide as an average edge and the boundary is taken by a plane sweep,
+// which is near linear for edges spread like the walls of a part, but edges crowding into one cell are compared pairwise.
+// False if a point is out of range or the boundary did not close, the result is not usable then.
+bool CombineContours(const GridContourSet& subject, const GridContourSet& clip, BooleanOperation operation, GridContourSet& result);
+// Combines subjects[i] with clips[i], layers run in parallel. Layers past the end of the clips are combined with an empty slice.
+// False if any layer failed.
+bool CombineLayers(std::span<const GridContourSet> subjects, std::span<const GridContourSet> clips, BooleanOperation operation, std::vector<GridContourSet>& results);
@@ -0,0 +1,174 @@
+#include "edgetable.h"
+#include "slicekernel.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <limits>
+
+static constexpr std::uint32_t s_noPoint = std::numeric_limits<std::uint32_t>::max();
+
+EdgeTable::EdgeTable(const IndexedMesh& mesh)
+{
+	// triangle corners are half edges, grouped by their smaller vertex with a counting sort
+	const std::size_t halfEdgeCount = mesh.indices.size();
+	auto ends = [&mesh](std::size_t halfEdge, std::uint32_t& low, std::uint32_t& high) {
+		const std::uint32_t a = mesh.indices[halfEdge];
+		const std::uint32_t b = mesh.indices[halfEdge - halfEdge % 3 + (halfEdge + 1) % 3];
+		low = std::min(a, b);
+		high = std::max(a, b);
+	};
+
+	std::vector<std::size_t> offsets(mesh.positions.size() + 1);
+	for (std::size_t i = 0; i < halfEdgeCount; ++i)
+	{
+		std::uint32_t low, high;
+		ends(i, low, high);
+		++offsets[low + 1];
+	}
+	for (std::size_t i = 1; i < offsets.size(); ++i)
+		offsets[i] += offsets[i - 1];
+	std::vector<std::uint32_t> byLow(halfEdgeCount);
+	{
+		std::vector<std::size_t> cursors(offsets.begin(), offsets.end() - 1);
+		for (std::size_t i = 0; i < halfEdgeCount; ++i)
+		{
+			std::uint32_t low, high;
+			ends(i, low, high);
+			byLow[cursors[low]++] = static_cast<std::uint32_t>(i);
+		}
+	}
+
+	// the half edges of a vertex are few, sorting them by the other end puts the twins next to each other
+	m_triangleEdges.resize(halfEdgeCount);
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> group;
+	for (std::size_t vertex = 0; vertex + 1 < offsets.size(); ++vertex)
+	{
+		group.clear();
+		for (std::size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+		{
+			std::uint32_t low, high;
+			ends(byLow[i], low, high);
+			group.emplace_back(high, byLow[i]);
+		}
+		std::sort(group.begin(), group.end());
+
+		for (std::size_t i = 0; i < group.size(); ++i)
+		{
+			if (0 == i || group[i].first != group[i - 1].first)
+				m_edges.push_back({ { static_cast<std::uint32_t>(vertex), group[i].first }, { group[i].second / 3, NoTriangle } });
+			else if (NoTriangle == m_edges.back().triangles[1])
+				m_edges.back().triangles[1] = group[i].second / 3;
+			m_triangleEdges[group[i].second] = static_cast<std::uint32_t>(m_edges.size() - 1);
+		}
+	}
+}
+
+EdgeSlice SliceEdges(const EdgeTable& edges, const IndexedMesh& mesh, const mth::float3x3& plainTransform, float plainDistFromOrigin, unsigned jobs)
+{
+	jobs = std::max(1u, jobs);
+	ThreadPool& pool = ThreadPool::Shared();
+	auto jobRange = [jobs](std::size_t count, std::size_t job, std::size_t& first, std::size_t& last) {
+		const std::size_t jobWorkCount = (count + jobs - 1) / jobs;
+		first = std::min(count, job * jobWorkCount);
+		last = std::min(count, first + jobWorkCount);
+	};
+
+	// every vertex is moved into the plain frame once instead of once for each of its corners
+	std::vector<mth::float3> frame(mesh.positions.size());
+	pool.ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t first, last;
+		jobRange(frame.size(), job, first, last);
+		for (std::size_t i = first; i < last; ++i)
+			frame[i] = PlainFramePoint(plainTransform, plainDistFromOrigin, mesh.positions[i]);
+		});
+
+	// crossed edges are counted first, so every job can number its points straight into the final arrays
+	auto crossed = [&frame](const EdgeTable::Edge& edge) { return frame[edge.vertices[0]].y * frame[edge.vertices[1]].y < 0.0f; };
+	std::vector<std::size_t> pointOffsets(static_cast<std::size_t>(jobs) + 1);
+	pool.ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t first, last;
+		jobRange(edges.EdgeCount(), job, first, last);
+		pointOffsets[job + 1] = static_cast<std::size_t>(std::count_if(edges.Edges().begin() + first, edges.Edges().begin() + last, crossed));
+		});
+	for (std::size_t job = 0; job < jobs; ++job)
+		pointOffsets[job + 1] += pointOffsets[job];
+
+	EdgeSlice slice;
+	slice.points.resize(pointOffsets[jobs]);
+	slice.pointEdges.resize(pointOffsets[jobs]);
+	std::vector<std::uint32_t> edgePoints(edges.EdgeCount());
+	pool.ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t first, last;
+		jobRange(edges.EdgeCount(), job, first, last);
+		std::size_t point = pointOffsets[job];
+		for (std::size_t i = first; i < last; ++i)
+		{
+			const EdgeTable::Edge& edge = edges.GetEdge(i);
+			if (crossed(edge))
+			{
+				slice.points[point] = PlainEdgeCrossing(frame[edge.vertices[0]], frame[edge.vertices[1]]);
+				slice.pointEdges[point] = static_cast<std::uint32_t>(i);
+				edgePoints[i] = static_cast<std::uint32_t>(point++);
+			}
+			else
+			{
+				edgePoints[i] = s_noPoint;
+			}
+		}
+		});
+
+	// a triangle only looks up the points of its edges, two of them make a segment
+	auto segmentEnds = [&](std::size_t triangle, std::uint32_t ends[2]) {
+		int count = 0;
+		for (int edge = 0; edge < 3; ++edge)
+		{
+			const std::uint32_t point = edgePoints[edges.TriangleEdge(triangle, edge)];
+			if (s_noPoint == point)
+				continue;
+			if (2 == count)
+				return false;
+			ends[count++] = point;
+		}
+		return 2 == count;	// a NaN corner can leave a single crossing
+	};
+	std::vector<std::size_t> segmentOffsets(static_cast<std::size_t>(jobs) + 1);
+	pool.ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t first, last;
+		jobRange(mesh.TriangleCount(), job, first, last);
+		std::size_t count = 0;
+		std::uint32_t ends[2];
+		for (std::size_t i = first; i < last; ++i)
+			count += segmentEnds(i, ends);
+		segmentOffsets[job + 1] = count;
+		});
+	for (std::size_t job = 0; job < jobs; ++job)
+		segmentOffsets[job + 1] += segmentOffsets[job];
+
+	slice.segments.resize(2 * segmentOffsets[jobs]);
+	pool.ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t first, last;
+		jobRange(mesh.TriangleCount(), job, first, last);
+		std::uint32_t* output = slice.segments.data() + 2 * segmentOffsets[job];
+		std::uint32_t ends[2];
+		for (std::size_t i = first; i < last; ++i)
+		{
+			if (!segmentEnds(i, ends))
+				continue;
+			// the outward facing normal of the triangle has to be on the right of the segment
+			const mth::float3& p0 = mesh.Position(i, 0);
+			const mth::float3& p1 = mesh.Position(i, 1);
+			const mth::float3& p2 = mesh.Position(i, 2);
+			const mth::float3 normal = plainTransform * (p1 - p0).Cross(p2 - p0);
+			const mth::float2 direction = slice.points[ends[1]] - slice.points[ends[0]];
+			const bool flip = direction.y * normal.x - direction.x * normal.z < 0.0f;
+			*output++ = ends[flip ? 1 : 0];
+			*output++ = ends[flip ? 0 : 1];
+		}
+		});
+	return slice;
+}
+
+ContourSet JoinEdgeSlice(const EdgeSlice& slice)
+{
+	// every crossed edge has a single point, so the segments chain through the point numbers
+	return JoinNumberedSegments(slice.points, slice.segments);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "mesh.h"
+#include "contour.h"
+#include <vector>
+#include <span>
+#include <cstdint>
+
+// The unique edges of a mesh with the triangles on either side.
+// Slicing through the table cuts every crossed edge once and lets both triangles on it refer to that one point.
+class EdgeTable
+{
+public:
+	static constexpr std::uint32_t NoTriangle = 0xffffffff;
+
+	struct Edge
+	{
+		std::uint32_t vertices[2];	// smaller index first
+		std::uint32_t triangles[2];	// the second is NoTriangle on an open edge, a non-manifold edge only lists its first two
+	};
+
+private:
+	std::vector<Edge> m_edges;
+	std::vector<std::uint32_t> m_triangleEdges;
+
+public:
+	explicit EdgeTable(const IndexedMesh& mesh);
+
+	inline std::size_t EdgeCount() const { return m_edges.size(); }
+	inline const Edge& GetEdge(std::size_t edge) const { return m_edges[edge]; }
+	inline std::span<const Edge> Edges() const { return m_edges; }
+	// edge i of a triangle runs from corner i to corner (i + 1) % 3
+	inline std::uint32_t TriangleEdge(std::size_t triangle, int edge) const { return m_triangleEdges[3 * triangle + edge]; }
+};
+
+// A slice cut edge by edge. Point i lies on edge pointEdges[i], segment i runs from point segments[2 * i] to segments[2 * i + 1]
+// with the outside of the solid on its right.
+struct EdgeSlice
+{
+	std::vector<mth::float2> points;
+	std::vector<std::uint32_t> pointEdges;
+	std::vector<std::uint32_t> segments;
+
+	inline std::size_t SegmentCount() const { return segments.size() / 2; }
+};
+
+// The points are the same as CalculateEdgeSegment gives, each one is just calculated once.
+EdgeSlice SliceEdges(const EdgeTable& edges, const IndexedMesh& mesh, const mth::float3x3& plainTransform, float plainDistFromOrigin, unsigned jobs);
+// Chains the segments through the points of their edges in time linear in the number of segments.
+ContourSet JoinEdgeSlice(const EdgeSlice& slice);
@@ -0,0 +1,121 @@
+#include "filemapping.h"
+#include <Windows.h>
+#include <utility>
+
+void FileMapping::Unmap()
+{
+	if (m_view)
+		UnmapViewOfFile(m_view);
+	m_view = nullptr;
+	m_data = nullptr;
+	m_mappedOffset = 0;
+	m_mappedSize = 0;
+}
+
+FileMapping::FileMapping()
+	: m_file{}
+	, m_mapping{}
+	, m_view{}
+	, m_data{}
+	, m_size{}
+	, m_mappedOffset{}
+	, m_mappedSize{} {}
+
+FileMapping::FileMapping(FileMapping&& other) noexcept
+	: m_file{ std::exchange(other.m_file, nullptr) }
+	, m_mapping{ std::exchange(other.m_mapping, nullptr) }
+	, m_view{ std::exchange(other.m_view, nullptr) }
+	, m_data{ std::exchange(other.m_data, nullptr) }
+	, m_size{ std::exchange(other.m_size, 0) }
+	, m_mappedOffset{ std::exchange(other.m_mappedOffset, 0) }
+	, m_mappedSize{ std::exchange(other.m_mappedSize, 0) } {}
+
+FileMapping::~FileMapping()
+{
+	Close();
+}
+
+FileMapping& FileMapping::operator=(FileMapping&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		m_file = std::exchange(other.m_file, nullptr);
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+		m_view = std::exchange(other.m_view, nullptr);
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_mappedOffset = std::exchange(other.m_mappedOffset, 0);
+		m_mappedSize = std::exchange(other.m_mappedSize, 0);
+	}
+	return *this;
+}
+
+bool FileMapping::Open(const wchar_t* filename, bool mapWholeFile)
+{
+	Close();
+
+	HANDLE file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (INVALID_HANDLE_VALUE == file)
+		return false;
+	m_file = file;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		Close();
+		return false;
+	}
+	m_size = static_cast<std::uint64_t>(fileSize.QuadPart);
+	if (0 == m_size)
+		return true;	// empty files cannot be mapped, but they are valid
+
+	m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (nullptr == m_mapping)
+	{
+		Close();
+		return false;
+	}
+	if (mapWholeFile && (static_cast<std::uint64_t>(static_cast<std::size_t>(m_size)) != m_size || !MapRange(0, static_cast<std::size_t>(m_size))))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool FileMapping::MapRange(std::uint64_t offset, std::size_t size)
+{
+	Unmap();
+	if (offset > m_size)
+		return false;
+	if (size > m_size - offset)
+		size = static_cast<std::size_t>(m_size - offset);
+	if (0 == size)
+		return true;
+
+	// views have to start on an allocation granularity boundary
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	const std::uint64_t viewOffset = offset - offset % systemInfo.dwAllocationGranularity;
+	const std::size_t viewSize = size + static_cast<std::size_t>(offset - viewOffset);
+	m_view = MapViewOfFile(m_mapping, FILE_MAP_READ, static_cast<DWORD>(viewOffset >> 32), static_cast<DWORD>(viewOffset & 0xffffffff), viewSize);
+	if (nullptr == m_view)
+		return false;
+	m_data = static_cast<const char*>(m_view) + (offset - viewOffset);
+	m_mappedOffset = offset;
+	m_mappedSize = size;
+	return true;
+}
+
+void FileMapping::Close()
+{
+	Unmap();
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file)
+		CloseHandle(m_file);
+	m_file = nullptr;
+	m_mapping = nullptr;
+	m_size = 0;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class FileMapping
+{
+	void* m_file;
+	void* m_mapping;
+	void* m_view;
+	const char* m_data;
+	std::uint64_t m_size;
+	std::uint64_t m_mappedOffset;
+	std::size_t m_mappedSize;
+
+private:
+	void Unmap();
+
+public:
+	FileMapping();
+	FileMapping(FileMapping&& other) noexcept;
+	FileMapping(const FileMapping&) = delete;
+	~FileMapping();
+	FileMapping& operator=(FileMapping&& other) noexcept;
+	FileMapping& operator=(const FileMapping&) = delete;
+
+	bool Open(const wchar_t* filename, bool mapWholeFile = true);
+	bool MapRange(std::uint64_t offset, std::size_t size);
+	void Close();
+
+	inline bool IsOpen() const { return nullptr != m_file; }
+	inline const char* Data() const { return m_data; }
+	inline std::size_t Size() const { return static_cast<std::size_t>(m_size); }
+	inline std::uint64_t FileSize() const { return m_size; }
+	inline std::uint64_t MappedOffset() const { return m_mappedOffset; }
+	inline std::size_t MappedSize() const { return m_mappedSize; }
+};
\ No newline at end of file
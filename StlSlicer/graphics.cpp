@@ -50,7 +50,81 @@ void Graphics::CreatePlain()
 	m_plainVertexCount = ARRAYSIZE(vertices);
 }
 
-void Graphics::RenderGeometry(const ShaderData& shaderData, ID3D11Buffer* vertexBuffer, unsigned vertexCount, D3D11_PRIMITIVE_TOPOLOGY topology) const
+void Graphics::CreateModelShaders()
+{
+	// The model is drawn from welded positions and an index buffer, so the flat face normals
+	// are read in the pixel shader from a structured buffer indexed by the primitive ID.
+	static const char s_VsCode[] = R"(
+cbuffer ShaderData
+{
+	matrix worldMatrix;
+	matrix cameraMatrix;
+	float3 eye;
+	float ambient;
+};
+struct PixelShaderInput
+{
+	float4 screenPosition : SV_POSITION;
+	float3 position : POSITION;
+};
+PixelShaderInput main(float4 position : POSITION)
+{
+	PixelShaderInput output;
+	output.screenPosition = mul(position, worldMatrix);
+	output.position = output.screenPosition.xyz;
+	output.screenPosition = mul(output.screenPosition, cameraMatrix);
+	return output;
+}
+)";
+	ComPtr<ID3DBlob> shaderCode;
+	ComPtr<ID3DBlob> compileError;
+	HRESULT hr = D3DCompile(s_VsCode, sizeof(s_VsCode) - 1, nullptr, nullptr, nullptr, "main", "vs_5_0", D3DCOMPILE_OPTIMIZATION_LEVEL2, 0, &shaderCode, &compileError);
+	if (FAILED(hr))
+	{
+		if (compileError)
+			OutputDebugStringA(reinterpret_cast<const char*>(compileError->GetBufferPointer()));
+		ThrowIfFailed(hr, "Failed to compile model vertex shader");
+	}
+	D3D11_INPUT_ELEMENT_DESC inputLayout[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+	ThrowIfFailed(m_device3D->CreateInputLayout(inputLayout, ARRAYSIZE(inputLayout), shaderCode->GetBufferPointer(), shaderCode->GetBufferSize(), &m_modelInputLayout), "Failed to create model input layout");
+	ThrowIfFailed(m_device3D->CreateVertexShader(shaderCode->GetBufferPointer(), shaderCode->GetBufferSize(), nullptr, &m_modelVertexShader), "Failed to create model vertex shader");
+
+	static const char s_PsCode[] = R"(
+cbuffer ShaderData
+{
+	matrix worldMatrix;
+	matrix cameraMatrix;
+	float3 eye;
+	float ambient;
+};
+StructuredBuffer<float3> faceNormals : register(t0);
+struct PixelShaderInput
+{
+	float4 screenPosition : SV_POSITION;
+	float3 position : POSITION;
+};
+float4 main(PixelShaderInput input, uint primitiveID : SV_PrimitiveID) : SV_TARGET
+{
+	float3 normal = mul(faceNormals[primitiveID], (float3x3)worldMatrix);
+	float3 lightDirection = normalize(eye - input.position);
+	float intensity = saturate(dot(normalize(normal), lightDirection));
+	intensity = ambient + (1.0f - ambient) * intensity;
+	return float4(intensity, intensity, intensity, 1.0f);
+}
+)";
+	hr = D3DCompile(s_PsCode, sizeof(s_PsCode) - 1, nullptr, nullptr, nullptr, "main", "ps_5_0", D3DCOMPILE_OPTIMIZATION_LEVEL2, 0, &shaderCode, &compileError);
+	if (FAILED(hr))
+	{
+		if (compileError)
+			OutputDebugStringA(reinterpret_cast<const char*>(compileError->GetBufferPointer()));
+		ThrowIfFailed(hr, "Failed to compile model pixel shader");
+	}
+	ThrowIfFailed(m_device3D->CreatePixelShader(shaderCode->GetBufferPointer(), shaderCode->GetBufferSize(), nullptr, &m_modelPixelShader), "Failed to create model pixel shader");
+}
+
+void Graphics::SetShaderData(const ShaderData& shaderData) const
 {
 	D3D11_MAPPED_SUBRESOURCE resource;
 	if (SUCCEEDED(m_context3D->Map(m_shaderConstBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &resource)))
@@ -58,19 +132,27 @@ void Graphics::RenderGeometry(const ShaderData& shaderData, ID3D11Buffer* vertex
 		std::memcpy(resource.pData, &shaderData, sizeof(ShaderData));
 		m_context3D->Unmap(m_shaderConstBuffer.Get(), 0);
 	}
+	m_context3D->VSSetConstantBuffers(0, 1, m_shaderConstBuffer.GetAddressOf());
+	m_context3D->PSSetConstantBuffers(0, 1, m_shaderConstBuffer.GetAddressOf());
+}
+
+void Graphics::RenderGeometry(const ShaderData& shaderData, ID3D11Buffer* vertexBuffer, unsigned vertexCount, D3D11_PRIMITIVE_TOPOLOGY topology) const
+{
+	SetShaderData(shaderData);
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
+	m_context3D->IASetInputLayout(m_inputLayout.Get());
+	m_context3D->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+	m_context3D->PSSetShader(m_pixelShader.Get(), nullptr, 0);
 	m_context3D->IASetPrimitiveTopology(topology);
 	m_context3D->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-	m_context3D->VSSetConstantBuffers(0, 1, m_shaderConstBuffer.GetAddressOf());
-	m_context3D->PSSetConstantBuffers(0, 1, m_shaderConstBuffer.GetAddressOf());
 	m_context3D->Draw(vertexCount, 0);
 }
 
 Graphics::Graphics()
 	: m_viewport{}
 	, m_plainVertexCount{}
-	, m_modelVertexCount{} {}
+	, m_modelIndexCount{} {}
 
 void Graphics::Init(HWND target)
 {
@@ -269,6 +351,7 @@ float4 main(PixelShaderInput input) : SV_TARGET
 	m_context2D->SetTarget(m_targetBitmap.Get());
 
 	CreatePlain();
+	CreateModelShaders();
 }
 
 void Graphics::Resize(int width, int height)
@@ -321,9 +404,6 @@ void Graphics::BeginDraw() const
 	m_context3D->OMSetDepthStencilState(m_depthStencilState.Get(), 0);
 	m_context3D->RSSetState(m_rasterizerState.Get());
 	m_context3D->RSSetViewports(1, &m_viewport);
-	m_context3D->IASetInputLayout(m_inputLayout.Get());
-	m_context3D->VSSetShader(m_vertexShader.Get(), nullptr, 0);
-	m_context3D->PSSetShader(m_pixelShader.Get(), nullptr, 0);
 
 	m_context2D->BeginDraw();
 }
@@ -339,25 +419,67 @@ void Graphics::RenderPlain(const ShaderData& shaderData) const
 	RenderGeometry(shaderData, m_plainVertexBuffer.Get(), m_plainVertexCount, D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
 }
 
-void Graphics::LoadModel(const Vertex* vertices, unsigned vertexCount)
+void Graphics::LoadModel(const IndexedMesh& mesh)
 {
-	D3D11_BUFFER_DESC bufferDesc{};
-	D3D11_SUBRESOURCE_DATA bufferData{};
 	ComPtr<ID3D11Buffer> vertexBuffer;
+	ComPtr<ID3D11Buffer> indexBuffer;
+	ComPtr<ID3D11Buffer> normalBuffer;
+	ComPtr<ID3D11ShaderResourceView> normalView;
 
-	bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
-	bufferDesc.ByteWidth = sizeof(*vertices) * vertexCount;
-	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bufferData.pSysMem = vertices;
-	ThrowIfFailed(m_device3D->CreateBuffer(&bufferDesc, &bufferData, &vertexBuffer), "Failed to create vertex buffer");
+	if (0 != mesh.TriangleCount())
+	{
+		D3D11_BUFFER_DESC bufferDesc{};
+		D3D11_SUBRESOURCE_DATA bufferData{};
+
+		bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		bufferDesc.ByteWidth = static_cast<UINT>(sizeof(mth::float3) * mesh.positions.size());
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		bufferData.pSysMem = mesh.positions.data();
+		ThrowIfFailed(m_device3D->CreateBuffer(&bufferDesc, &bufferData, &vertexBuffer), "Failed to create vertex buffer");
+
+		bufferDesc.ByteWidth = static_cast<UINT>(sizeof(std::uint32_t) * mesh.indices.size());
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		bufferData.pSysMem = mesh.indices.data();
+		ThrowIfFailed(m_device3D->CreateBuffer(&bufferDesc, &bufferData, &indexBuffer), "Failed to create index buffer");
+
+		bufferDesc.ByteWidth = static_cast<UINT>(sizeof(mth::float3) * mesh.faceNormals.size());
+		bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bufferDesc.StructureByteStride = sizeof(mth::float3);
+		bufferData.pSysMem = mesh.faceNormals.data();
+		ThrowIfFailed(m_device3D->CreateBuffer(&bufferDesc, &bufferData, &normalBuffer), "Failed to create normal buffer");
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc{};
+		viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		viewDesc.Buffer.FirstElement = 0;
+		viewDesc.Buffer.NumElements = static_cast<UINT>(mesh.faceNormals.size());
+		ThrowIfFailed(m_device3D->CreateShaderResourceView(normalBuffer.Get(), &viewDesc, &normalView), "Failed to create normal buffer view");
+	}
 
 	m_modelVertexBuffer = std::move(vertexBuffer);
-	m_modelVertexCount = vertexCount;
+	m_modelIndexBuffer = std::move(indexBuffer);
+	m_modelNormalBuffer = std::move(normalBuffer);
+	m_modelNormalView = std::move(normalView);
+	m_modelIndexCount = static_cast<UINT>(mesh.indices.size());
 }
 
 void Graphics::RenderModel(const ShaderData& shaderData) const
 {
-	RenderGeometry(shaderData, m_modelVertexBuffer.Get(), m_modelVertexCount, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	if (0 == m_modelIndexCount)
+		return;
+
+	SetShaderData(shaderData);
+	UINT stride = sizeof(mth::float3);
+	UINT offset = 0;
+	m_context3D->IASetInputLayout(m_modelInputLayout.Get());
+	m_context3D->VSSetShader(m_modelVertexShader.Get(), nullptr, 0);
+	m_context3D->PSSetShader(m_modelPixelShader.Get(), nullptr, 0);
+	m_context3D->PSSetShaderResources(0, 1, m_modelNormalView.GetAddressOf());
+	m_context3D->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_context3D->IASetVertexBuffers(0, 1, m_modelVertexBuffer.GetAddressOf(), &stride, &offset);
+	m_context3D->IASetIndexBuffer(m_modelIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	m_context3D->DrawIndexed(m_modelIndexCount, 0, 0);
 }
 
 ComPtr<ID2D1SolidColorBrush> Graphics::CreateBrush(mth::float4 color) const
@@ -38,11 +38,19 @@ class Graphics
 
 	ComPtr<ID3D11Buffer> m_plainVertexBuffer;
 	UINT m_plainVertexCount;
+	ComPtr<ID3D11InputLayout> m_modelInputLayout;
+	ComPtr<ID3D11VertexShader> m_modelVertexShader;
+	ComPtr<ID3D11PixelShader> m_modelPixelShader;
 	ComPtr<ID3D11Buffer> m_modelVertexBuffer;
-	UINT m_modelVertexCount;
+	ComPtr<ID3D11Buffer> m_modelIndexBuffer;
+	ComPtr<ID3D11Buffer> m_modelNormalBuffer;
+	ComPtr<ID3D11ShaderResourceView> m_modelNormalView;
+	UINT m_modelIndexCount;
 
 private:
 	void CreatePlain();
+	void CreateModelShaders();
+	void SetShaderData(const ShaderData& shaderData) const;
 	void RenderGeometry(const ShaderData& shaderData, ID3D11Buffer* vertexBuffer, unsigned vertexCount, D3D11_PRIMITIVE_TOPOLOGY topology) const;
 
 public:
@@ -55,7 +63,7 @@ public:
 
 	void RenderPlain(const ShaderData& shaderData) const;
 
-	void LoadModel(const Vertex* vertices, unsigned vertexCount);
+	void LoadModel(const IndexedMesh& mesh);
 	void RenderModel(const ShaderData& shaderData) const;
 
 	ComPtr<ID2D1SolidColorBrush> CreateBrush(mth::float4 color) const;
@@ -0,0 +1,95 @@
+#include "gridmesh.h"
+#include <cmath>
+
+bool GridMesh::Quantize(const IndexedMesh& mesh, double step)
+{
+	m_step = step;
+	m_positions.resize(mesh.positions.size());
+	for (std::size_t i = 0; i < m_positions.size(); ++i)
+	{
+		const mth::float3& p = mesh.positions[i];
+		const float coords[] = { p.x, p.y, p.z };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const double steps = std::round(static_cast<double>(coords[axis]) / step);
+			if (!(std::abs(steps) <= static_cast<double>(CoordinateLimit)))
+			{
+				m_positions.clear();
+				return false;
+			}
+			m_positions[i].coords[axis] = static_cast<std::int64_t>(steps);
+		}
+	}
+	return true;
+}
+
+std::int64_t GridMesh::ToGrid(float value) const
+{
+	// just outside the grid the plain misses every triangle, NaN goes above it
+	const double steps = std::round(static_cast<double>(value) / m_step);
+	const double outside = static_cast<double>(CoordinateLimit + 1);
+	if (!(steps > -outside))
+		return steps < 0.0 ? -(CoordinateLimit + 1) : CoordinateLimit + 1;
+	return steps < outside ? static_cast<std::int64_t>(steps) : CoordinateLimit + 1;
+}
+
+mth::float2 GridMesh::ToModel(GridPoint point) const
+{
+	return mth::float2(static_cast<float>(static_cast<double>(point.x) * m_step), static_cast<float>(static_cast<double>(point.y) * m_step));
+}
+
+// the nearest integer to numerator / denominator with halves rounded up, which gives the same point from either end of an edge
+static inline std::int64_t RoundedQuotient(std::int64_t numerator, std::int64_t denominator)
+{
+	std::int64_t quotient = numerator / denominator;
+	std::int64_t remainder = numerator % denominator;
+	if (remainder < 0)
+	{
+		--quotient;
+		remainder += denominator;
+	}
+	return 2 * remainder >= denominator ? quotient + 1 : quotient;
+}
+
+static inline GridPoint GridCrossing(const std::int64_t from[3], const std::int64_t to[3], std::int64_t plainDistance)
+{
+	// both factors are below 2^31 within the coordinate limit
+	std::int64_t rise = to[1] - from[1];
+	std::int64_t climb = plainDistance - from[1];
+	if (rise < 0)
+	{
+		rise = -rise;
+		climb = -climb;
+	}
+	return { from[0] + RoundedQuotient((to[0] - from[0]) * climb, rise), from[2] + RoundedQuotient((to[2] - from[2]) * climb, rise) };
+}
+
+bool CalculateGridSegment(GridSegment& segment, const GridMesh& grid, const IndexedMesh& mesh, std::size_t triangle, PlainAxis axis, std::int64_t plainDistance)
+{
+	const std::uint32_t* vertices = &mesh.indices[3 * triangle];
+	std::int64_t v[3][3];
+	for (int corner = 0; corner < 3; ++corner)
+	{
+		const GridMesh::Position& p = grid.Positions()[vertices[corner]];
+		for (int frameAxis = 0; frameAxis < 3; ++frameAxis)
+		{
+			const std::int64_t coord = p.coords[PlainAxisSource(axis, frameAxis)];
+			v[corner][frameAxis] = PlainAxisNegated(axis, frameAxis) ? -coord : coord;
+		}
+	}
+
+	// with the outside on the right the segment runs from the edge rising through the plain to the one falling through it
+	bool found[2] = {};
+	for (int edge = 0; edge < 3; ++edge)
+	{
+		const int a = edge, b = (edge + 1) % 3;
+		const bool aboveA = v[a][1] >= plainDistance;
+		if (aboveA == (v[b][1] >= plainDistance))
+			continue;
+		const int end = aboveA ? 1 : 0;
+		segment.points[end] = GridCrossing(v[a], v[b], plainDistance);
+		segment.edges[end] = EdgeKey(vertices[a], vertices[b]);
+		found[end] = true;
+	}
+	return found[0] && found[1];
+}
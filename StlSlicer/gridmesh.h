@@ -0,0 +1,50 @@
+#pragma once
+
+#include "mesh.h"
+#include "contour.h"
+#include "slicekernel.h"
+#include <vector>
+#include <span>
+#include <cstdint>
+
+// A point of a grid slice, x and y hold the plain frame x and z like the float slices do.
+struct GridPoint
+{
+	std::int64_t x;
+	std::int64_t y;
+};
+using GridSegment = BasicEdgeSegment<GridPoint>;
+using GridContourSet = BasicContourSet<GridPoint>;
+
+// The positions of a mesh rounded to a 64 bit integer grid, so slices along a grid axis can be cut in exact integer arithmetic.
+// Coordinates stay within CoordinateLimit steps of the origin, which keeps every product of the slicing within 64 bits.
+class GridMesh
+{
+public:
+	static constexpr double DefaultStep = 1e-3;	// a micrometre with the model in millimetres
+	static constexpr std::int64_t CoordinateLimit = std::int64_t(1) << 30;
+
+	struct Position
+	{
+		std::int64_t coords[3];
+	};
+
+private:
+	std::vector<Position> m_positions;
+	double m_step = DefaultStep;
+
+public:
+	// false if a coordinate is not finite or does not fit the grid, the grid is left empty then
+	bool Quantize(const IndexedMesh& mesh, double step = DefaultStep);
+
+	inline double Step() const { return m_step; }
+	inline std::span<const Position> Positions() const { return m_positions; }
+	// rounded to the nearest grid step, values off the grid are clamped just outside it
+	std::int64_t ToGrid(float value) const;
+	mth::float2 ToModel(GridPoint point) const;
+};
+
+// Cuts one triangle of the quantized mesh with the plain plainDistance steps along an axis normal.
+// Corners on the plain count as above it like in the float kernels, and every end point is rounded the same way
+// from either triangle on its edge, so neighbours share it exactly. The segment is oriented like CalculateEdgeSegment does.
+bool CalculateGridSegment(GridSegment& segment, const GridMesh& grid, const IndexedMesh& mesh, std::size_t triangle, PlainAxis axis, std::int64_t plainDistance);
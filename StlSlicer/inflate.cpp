@@ -0,0 +1,428 @@
+#include "inflate.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+static constexpr std::size_t s_windowSize = 1 << 15;
+static constexpr std::size_t s_flushSize = 1 << 18;
+static constexpr std::size_t s_maxMatchLength = 258;
+static constexpr unsigned s_maxCodeLength = 15;
+static constexpr unsigned s_invalidSymbol = 0xffff;
+
+static constexpr std::uint16_t s_lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static constexpr std::uint8_t s_lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static constexpr std::uint16_t s_distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static constexpr std::uint8_t s_distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static constexpr std::uint8_t s_codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+static std::uint32_t Crc32(std::uint32_t crc, const char* data, std::size_t size)
+{
+	static const std::vector<std::uint32_t> table = []() {
+		std::vector<std::uint32_t> t(256);
+		for (std::uint32_t i = 0; i < 256; ++i)
+		{
+			std::uint32_t c = i;
+			for (int k = 0; k < 8; ++k)
+				c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			t[i] = c;
+		}
+		return t;
+	}();
+
+	crc = ~crc;
+	for (std::size_t i = 0; i < size; ++i)
+		crc = table[(crc ^ static_cast<std::uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+static std::uint32_t ReadLE32(const char* data)
+{
+	const std::uint8_t* b = reinterpret_cast<const std::uint8_t*>(data);
+	return b[0] | b[1] << 8 | b[2] << 16 | static_cast<std::uint32_t>(b[3]) << 24;
+}
+
+class BitReader
+{
+	const std::uint8_t* m_data;
+	std::size_t m_size;
+	std::size_t m_position;	// bytes moved into the bit buffer, runs past the end when the stream is truncated
+	std::uint64_t m_bits;
+	unsigned m_count;
+
+public:
+	BitReader(const char* data, std::size_t size)
+		: m_data{ reinterpret_cast<const std::uint8_t*>(data) }
+		, m_size{ size }
+		, m_position{}
+		, m_bits{}
+		, m_count{} {}
+
+	// keeps at least 56 bits in the buffer, missing bytes past the end read as zero
+	inline void Refill()
+	{
+		if (m_position + sizeof(m_bits) <= m_size)
+		{
+			std::uint64_t word;
+			std::memcpy(&word, m_data + m_position, sizeof(word));
+			m_bits |= word << m_count;
+			m_position += (63 - m_count) >> 3;
+			m_count |= 56;
+		}
+		else
+		{
+			for (; m_count <= 56; m_count += 8, ++m_position)
+				m_bits |= static_cast<std::uint64_t>(m_position < m_size ? m_data[m_position] : 0) << m_count;
+		}
+	}
+	inline unsigned Peek(unsigned count) const { return static_cast<unsigned>(m_bits & ((std::uint64_t(1) << count) - 1)); }
+	inline void Consume(unsigned count) { m_bits >>= count; m_count -= count; }
+	inline unsigned Bits(unsigned count)
+	{
+		Refill();
+		const unsigned value = Peek(count);
+		Consume(count);
+		return value;
+	}
+	inline void AlignToByte() { Consume(m_count & 7); }
+	inline void Seek(std::size_t position)
+	{
+		m_position = position;
+		m_bits = 0;
+		m_count = 0;
+	}
+	inline std::size_t Consumed() const { return m_position - m_count / 8; }
+	inline bool Overrun() const { return Consumed() > m_size; }
+	inline const char* Data() const { return reinterpret_cast<const char*>(m_data); }
+	inline std::size_t Size() const { return m_size; }
+};
+
+// Canonical Huffman code decoded with a single table indexed by the next bits of the stream.
+class Huffman
+{
+	std::vector<std::uint16_t> m_table;	// symbol << 4 | code length, zero for unused codes
+	unsigned m_bits;
+
+public:
+	Huffman()
+		: m_bits{} {}
+
+	bool Build(const std::uint8_t* lengths, unsigned count)
+	{
+		unsigned lengthCounts[s_maxCodeLength + 1]{};
+		for (unsigned i = 0; i < count; ++i)
+			++lengthCounts[lengths[i]];
+		lengthCounts[0] = 0;
+
+		int left = 1;
+		m_bits = 1;
+		unsigned nextCode[s_maxCodeLength + 1]{};
+		for (unsigned length = 1, code = 0; length <= s_maxCodeLength; ++length)
+		{
+			left = 2 * left - static_cast<int>(lengthCounts[length]);
+			if (left < 0)
+				return false;
+			if (lengthCounts[length])
+				m_bits = length;
+			code = (code + lengthCounts[length - 1]) << 1;
+			nextCode[length] = code;
+		}
+
+		// incomplete codes are accepted, their unused entries fail when decoded
+		m_table.assign(std::size_t(1) << m_bits, 0);
+		for (unsigned symbol = 0; symbol < count; ++symbol)
+		{
+			const unsigned length = lengths[symbol];
+			if (0 == length)
+				continue;
+			const unsigned code = nextCode[length]++;
+			unsigned reversed = 0;
+			for (unsigned i = 0; i < length; ++i)
+				reversed |= (code >> i & 1) << (length - 1 - i);
+			for (std::size_t i = reversed; i < m_table.size(); i += std::size_t(1) << length)
+				m_table[i] = static_cast<std::uint16_t>(symbol << 4 | length);
+		}
+		return true;
+	}
+
+	inline unsigned Decode(BitReader& reader) const
+	{
+		reader.Refill();
+		const std::uint16_t entry = m_table[reader.Peek(m_bits)];
+		if (0 == entry)
+			return s_invalidSymbol;
+		reader.Consume(entry & 15);
+		return entry >> 4;
+	}
+};
+
+class Inflater
+{
+	BitReader m_reader;
+	const InflateSink& m_sink;
+	std::vector<char> m_output;	// the last 32K of output followed by the data not handed to the sink yet
+	std::size_t m_outputSize;
+	std::size_t m_flushed;
+	std::uint32_t m_crc;
+	std::uint32_t m_memberSize;
+
+private:
+	bool Flush()
+	{
+		const std::size_t count = m_outputSize - m_flushed;
+		m_crc = Crc32(m_crc, m_output.data() + m_flushed, count);
+		m_memberSize += static_cast<std::uint32_t>(count);
+		if (count && !m_sink(m_output.data() + m_flushed, count, std::min(m_reader.Consumed(), m_reader.Size())))
+			return false;
+		if (m_outputSize > s_windowSize)
+		{
+			std::memmove(m_output.data(), m_output.data() + m_outputSize - s_windowSize, s_windowSize);
+			m_outputSize = s_windowSize;
+		}
+		m_flushed = m_outputSize;
+		return true;
+	}
+
+	bool Stored()
+	{
+		m_reader.AlignToByte();
+		std::size_t position = m_reader.Consumed();
+		if (position + 4 > m_reader.Size())
+			return false;
+		const std::uint32_t header = ReadLE32(m_reader.Data() + position);
+		std::size_t length = header & 0xffff;
+		if ((header >> 16) != (~header & 0xffff) || position + 4 + length > m_reader.Size())
+			return false;
+		position += 4;
+
+		while (length)
+		{
+			const std::size_t count = std::min(length, s_windowSize + s_flushSize - m_outputSize);
+			std::memcpy(m_output.data() + m_outputSize, m_reader.Data() + position, count);
+			m_outputSize += count;
+			position += count;
+			length -= count;
+			if (m_outputSize >= s_windowSize + s_flushSize && !Flush())
+				return false;
+		}
+		m_reader.Seek(position);
+		return true;
+	}
+
+	bool Codes(const Huffman& literals, const Huffman& distances)
+	{
+		while (true)
+		{
+			unsigned symbol = literals.Decode(m_reader);
+			if (symbol < 256)
+			{
+				m_output[m_outputSize++] = static_cast<char>(symbol);
+			}
+			else if (256 == symbol)
+			{
+				return !m_reader.Overrun();
+			}
+			else
+			{
+				symbol -= 257;
+				if (symbol >= 29)
+					return false;
+				const std::size_t length = s_lengthBase[symbol] + m_reader.Bits(s_lengthExtra[symbol]);
+				symbol = distances.Decode(m_reader);
+				if (symbol >= 30)
+					return false;
+				const std::size_t distance = s_distanceBase[symbol] + m_reader.Bits(s_distanceExtra[symbol]);
+				if (distance > m_outputSize)
+					return false;
+
+				char* target = m_output.data() + m_outputSize;
+				const char* source = target - distance;
+				if (distance >= length)
+					std::memcpy(target, source, length);
+				else
+					for (std::size_t i = 0; i < length; ++i)
+						target[i] = source[i];
+				m_outputSize += length;
+			}
+
+			if (m_outputSize >= s_windowSize + s_flushSize)
+			{
+				if (m_reader.Overrun() || !Flush())
+					return false;
+			}
+		}
+	}
+
+	bool Fixed()
+	{
+		static const std::vector<Huffman> tables = []() {
+			std::uint8_t lengths[288];
+			std::fill(lengths, lengths + 144, 8);
+			std::fill(lengths + 144, lengths + 256, 9);
+			std::fill(lengths + 256, lengths + 280, 7);
+			std::fill(lengths + 280, lengths + 288, 8);
+			std::vector<Huffman> t(2);
+			t[0].Build(lengths, 288);
+			std::fill(lengths, lengths + 30, 5);
+			t[1].Build(lengths, 30);
+			return t;
+		}();
+		return Codes(tables[0], tables[1]);
+	}
+
+	bool Dynamic()
+	{
+		const unsigned literalCount = m_reader.Bits(5) + 257;
+		const unsigned distanceCount = m_reader.Bits(5) + 1;
+		const unsigned codeLengthCount = m_reader.Bits(4) + 4;
+		if (literalCount > 286 || distanceCount > 30)
+			return false;
+
+		std::uint8_t lengths[286 + 30]{};
+		for (unsigned i = 0; i < codeLengthCount; ++i)
+			lengths[s_codeLengthOrder[i]] = static_cast<std::uint8_t>(m_reader.Bits(3));
+		Huffman codeLengths;
+		if (!codeLengths.Build(lengths, 19))
+			return false;
+
+		std::fill(std::begin(lengths), std::end(lengths), 0);
+		for (unsigned i = 0; i < literalCount + distanceCount;)
+		{
+			const unsigned symbol = codeLengths.Decode(m_reader);
+			if (symbol < 16)
+			{
+				lengths[i++] = static_cast<std::uint8_t>(symbol);
+				continue;
+			}
+			std::uint8_t value = 0;
+			unsigned repeat;
+			if (16 == symbol)
+			{
+				if (0 == i)
+					return false;
+				value = lengths[i - 1];
+				repeat = 3 + m_reader.Bits(2);
+			}
+			else if (17 == symbol)
+			{
+				repeat = 3 + m_reader.Bits(3);
+			}
+			else if (18 == symbol)
+			{
+				repeat = 11 + m_reader.Bits(7);
+			}
+			else
+			{
+				return false;
+			}
+			if (i + repeat > literalCount + distanceCount)
+				return false;
+			std::fill(lengths + i, lengths + i + repeat, value);
+			i += repeat;
+		}
+		if (0 == lengths[256])
+			return false;
+
+		Huffman literals, distances;
+		return literals.Build(lengths, literalCount) && distances.Build(lengths + literalCount, distanceCount) && Codes(literals, distances);
+	}
+
+	bool Header(std::size_t& position) const
+	{
+		const char* data = m_reader.Data();
+		const std::size_t size = m_reader.Size();
+		if (!IsGzip(data + position, size - position))
+			return false;
+		const std::uint8_t flags = static_cast<std::uint8_t>(data[position + 3]);
+		if (flags & 0xe0)
+			return false;
+		position += 10;
+		if (flags & 0x04)	// extra field
+		{
+			if (position + 2 > size)
+				return false;
+			position += 2 + (static_cast<std::uint8_t>(data[position]) | static_cast<std::uint8_t>(data[position + 1]) << 8);
+		}
+		for (std::uint8_t text : { std::uint8_t(0x08), std::uint8_t(0x10) })	// file name, comment
+		{
+			if (0 == (flags & text))
+				continue;
+			const void* terminator = position < size ? std::memchr(data + position, 0, size - position) : nullptr;
+			if (nullptr == terminator)
+				return false;
+			position = static_cast<const char*>(terminator) - data + 1;
+		}
+		if (flags & 0x02)	// header crc
+			position += 2;
+		return position < size;
+	}
+
+public:
+	Inflater(const char* data, std::size_t size, const InflateSink& sink)
+		: m_reader{ data, size }
+		, m_sink{ sink }
+		, m_output(s_windowSize + s_flushSize + s_maxMatchLength)
+		, m_outputSize{}
+		, m_flushed{}
+		, m_crc{}
+		, m_memberSize{} {}
+
+	bool Run()
+	{
+		std::size_t position = 0;
+		do
+		{
+			if (!Header(position))
+				return false;
+			m_reader.Seek(position);
+			m_crc = 0;
+			m_memberSize = 0;
+
+			bool last;
+			do
+			{
+				last = 1 == m_reader.Bits(1);
+				bool decoded;
+				switch (m_reader.Bits(2))
+				{
+				case 0: decoded = Stored(); break;
+				case 1: decoded = Fixed(); break;
+				case 2: decoded = Dynamic(); break;
+				default: decoded = false; break;
+				}
+				if (!decoded || m_reader.Overrun())
+					return false;
+			} while (!last);
+			if (!Flush())
+				return false;
+
+			m_reader.AlignToByte();
+			position = m_reader.Consumed();
+			if (position + 8 > m_reader.Size())
+				return false;
+			if (ReadLE32(m_reader.Data() + position) != m_crc || ReadLE32(m_reader.Data() + position + 4) != m_memberSize)
+				return false;
+			position += 8;
+		} while (IsGzip(m_reader.Data() + position, m_reader.Size() - position));	// concatenated members, anything else after them is ignored
+		return true;
+	}
+};
+
+bool IsGzip(const char* data, std::size_t size)
+{
+	return size >= 18 && '\x1f' == data[0] && '\x8b' == data[1] && 8 == data[2];
+}
+
+bool IsZstd(const char* data, std::size_t size)
+{
+	return size >= 4 && 0 == std::memcmp(data, "\x28\xb5\x2f\xfd", 4);
+}
+
+std::uint32_t GzipSizeHint(const char* data, std::size_t size)
+{
+	return size >= 4 ? ReadLE32(data + size - 4) : 0;
+}
+
+bool InflateGzip(const char* data, std::size_t size, const InflateSink& sink)
+{
+	return Inflater(data, size, sink).Run();
+}
\ No newline at end of file
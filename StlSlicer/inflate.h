@@ -0,0 +1,17 @@
+#pragma once
+
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+// Receives the decompressed data in order, together with the number of compressed bytes consumed so far.
+// Returning false stops the decompression.
+using InflateSink = std::function<bool(const char* data, std::size_t size, std::size_t consumed)>;
+
+bool IsGzip(const char* data, std::size_t size);
+bool IsZstd(const char* data, std::size_t size);
+// decompressed size of the last member modulo 2^32, as stored in the gzip trailer
+std::uint32_t GzipSizeHint(const char* data, std::size_t size);
+// Decompresses every member of a gzip file and checks their CRCs.
+// Returns false on corrupt or truncated data, or when the sink stopped the decompression.
+bool InflateGzip(const char* data, std::size_t size, const InflateSink& sink);
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "loadjob.h"
+#include <chrono>
+
+void LoadJob::Finish()
+{
+	bool loaded = false;
+	try
+	{
+		loaded = m_future.get();
+	}
+	catch (const std::exception& ex)
+	{
+		m_error = ex.what();
+	}
+
+	if (loaded)
+		m_state = State::Succeeded;
+	else if (m_progress.IsCancelled())
+		m_state = State::Cancelled;
+	else
+		m_state = State::Failed;
+}
+
+LoadJob::LoadJob(const wchar_t* filename)
+	: m_filename{ filename }
+	, m_state{ State::Running }
+{
+	m_future = std::async(std::launch::async, [this]() { return m_model.Load(m_filename.c_str(), &m_progress); });
+}
+
+LoadJob::~LoadJob()
+{
+	if (State::Running == m_state)
+	{
+		Cancel();
+		Wait();
+	}
+}
+
+LoadJob::State LoadJob::Poll()
+{
+	if (State::Running == m_state && std::future_status::ready == m_future.wait_for(std::chrono::seconds(0)))
+		Finish();
+	return m_state;
+}
+
+LoadJob::State LoadJob::Wait()
+{
+	if (State::Running == m_state)
+		Finish();
+	return m_state;
+}
+
+void LoadJob::Cancel()
+{
+	m_progress.Cancel();
+}
+
+Model LoadJob::TakeModel()
+{
+	return std::move(m_model);
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "model.h"
+#include "loadprogress.h"
+#include <future>
+#include <string>
+
+// Loads a model on a background thread. The job owns the model until it is taken after a successful load.
+class LoadJob
+{
+public:
+	enum class State
+	{
+		Running,
+		Succeeded,
+		Failed,
+		Cancelled
+	};
+
+private:
+	std::wstring m_filename;
+	Model m_model;
+	LoadProgress m_progress;
+	std::future<bool> m_future;
+	State m_state;
+	std::string m_error;
+
+private:
+	void Finish();
+
+public:
+	LoadJob(const wchar_t* filename);
+	LoadJob(const LoadJob&) = delete;
+	~LoadJob();
+	LoadJob& operator=(const LoadJob&) = delete;
+
+	State Poll();
+	State Wait();
+	void Cancel();
+	Model TakeModel();
+
+	inline const std::wstring& Filename() const { return m_filename; }
+	inline const LoadProgress& Progress() const { return m_progress; }
+	inline const std::string& Error() const { return m_error; }
+};
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Shared between a loader and whoever watches it, every member can be used from any thread.
+class LoadProgress
+{
+	std::atomic<std::uint64_t> m_processedBytes;
+	std::atomic<std::uint64_t> m_totalBytes;
+	std::atomic<bool> m_cancelled;
+
+public:
+	LoadProgress()
+		: m_processedBytes{}
+		, m_totalBytes{}
+		, m_cancelled{} {}
+
+	// several loads can share one progress, each adds the size of its own input
+	inline void AddTotal(std::uint64_t bytes) { m_totalBytes.fetch_add(bytes, std::memory_order_relaxed); }
+	inline void Advance(std::uint64_t bytes) { m_processedBytes.fetch_add(bytes, std::memory_order_relaxed); }
+	inline void Cancel() { m_cancelled.store(true); }
+
+	inline bool IsCancelled() const { return m_cancelled.load(); }
+	inline std::uint64_t ProcessedBytes() const { return m_processedBytes.load(std::memory_order_relaxed); }
+	inline std::uint64_t TotalBytes() const { return m_totalBytes.load(std::memory_order_relaxed); }
+	inline float Fraction() const
+	{
+		const std::uint64_t total = TotalBytes();
+		return 0 == total ? 0.0f : static_cast<float>(static_cast<double>(ProcessedBytes()) / static_cast<double>(total));
+	}
+};
\ No newline at end of file
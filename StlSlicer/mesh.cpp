@@ -0,0 +1,178 @@
+#include "mesh.h"
+#include "filemapping.h"
+#include "threadpool.h"
+#include <bit>
+#include <limits>
+#include <algorithm>
+
+static constexpr std::size_t s_weldVerticesPerJob = 1 << 16;
+
+static inline std::uint32_t PositionBits(float f)
+{
+	return std::bit_cast<std::uint32_t>(0.0f == f ? 0.0f : f);	// -0 and +0 are the same corner
+}
+
+static inline bool SamePosition(const mth::float3& a, const mth::float3& b)
+{
+	return PositionBits(a.x) == PositionBits(b.x) && PositionBits(a.y) == PositionBits(b.y) && PositionBits(a.z) == PositionBits(b.z);
+}
+
+static inline std::uint32_t PositionHash(const mth::float3& p)
+{
+	std::uint32_t h = PositionBits(p.x) * 0x9e3779b1u;
+	h = (h ^ (h >> 15) ^ PositionBits(p.y)) * 0x85ebca77u;
+	h = (h ^ (h >> 13) ^ PositionBits(p.z)) * 0xc2b2ae3du;
+	return h ^ (h >> 16);
+}
+
+static inline std::size_t Shard(std::uint32_t hash, std::size_t shardCount)
+{
+	return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * shardCount) >> 32);
+}
+
+bool IndexedMesh::Weld(const Vertex* vertices, std::size_t vertexCount)
+{
+	if (vertexCount % 3 != 0 || vertexCount > std::numeric_limits<std::uint32_t>::max())
+		return false;
+
+	const std::size_t jobs = std::clamp<std::size_t>(vertexCount / s_weldVerticesPerJob, 1, ThreadPool::Shared().ThreadCount() + 1);
+	const std::size_t shardCount = jobs;
+	const std::size_t jobWorkCount = (vertexCount + jobs - 1) / jobs;
+	auto jobBegin = [=](std::size_t job) { return std::min(vertexCount, job * jobWorkCount); };
+
+	// the vertices are grouped by hash shard, so every shard can be welded on its own
+	std::vector<std::uint32_t> hashes(vertexCount);
+	std::vector<std::size_t> shardOffsets(jobs * shardCount + 1);
+	ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t* counts = &shardOffsets[1 + job * shardCount];
+		for (std::size_t i = jobBegin(job); i < jobBegin(job + 1); ++i)
+		{
+			hashes[i] = PositionHash(vertices[i].position);
+			++counts[Shard(hashes[i], shardCount)];
+		}
+		});
+	// offsets are ordered shard first, job second, which keeps every shard in input order
+	std::vector<std::size_t> shardBegin(shardCount + 1);
+	{
+		std::size_t offset = 0;
+		for (std::size_t shard = 0; shard < shardCount; ++shard)
+		{
+			shardBegin[shard] = offset;
+			for (std::size_t job = 0; job < jobs; ++job)
+			{
+				const std::size_t count = shardOffsets[1 + job * shardCount + shard];
+				shardOffsets[1 + job * shardCount + shard] = offset;
+				offset += count;
+			}
+		}
+		shardBegin[shardCount] = offset;
+	}
+	std::vector<std::uint32_t> order(vertexCount);
+	ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t* offsets = &shardOffsets[1 + job * shardCount];
+		for (std::size_t i = jobBegin(job); i < jobBegin(job + 1); ++i)
+			order[offsets[Shard(hashes[i], shardCount)]++] = static_cast<std::uint32_t>(i);
+		});
+
+	// every vertex gets the index of the first vertex with the same position
+	std::vector<std::uint32_t> firstOccurrence(vertexCount);
+	ThreadPool::Shared().ParallelFor(shardCount, [&](std::size_t shard) {
+		const std::size_t count = shardBegin[shard + 1] - shardBegin[shard];
+		const std::size_t mask = std::bit_ceil(std::max<std::size_t>(2 * count, 16)) - 1;
+		std::vector<std::uint32_t> table(mask + 1, std::numeric_limits<std::uint32_t>::max());
+		for (std::size_t k = shardBegin[shard]; k < shardBegin[shard + 1]; ++k)
+		{
+			const std::uint32_t i = order[k];
+			std::size_t slot = hashes[i] & mask;
+			while (table[slot] != std::numeric_limits<std::uint32_t>::max() && !SamePosition(vertices[table[slot]].position, vertices[i].position))
+				slot = (slot + 1) & mask;
+			if (table[slot] == std::numeric_limits<std::uint32_t>::max())
+				table[slot] = i;
+			firstOccurrence[i] = table[slot];
+		}
+		});
+	order = std::vector<std::uint32_t>();
+
+	// first occurrences are numbered in input order, the hashes are not needed anymore and hold the new indices
+	std::vector<std::size_t> uniqueOffsets(jobs + 1);
+	ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t count = 0;
+		for (std::size_t i = jobBegin(job); i < jobBegin(job + 1); ++i)
+			count += firstOccurrence[i] == i;
+		uniqueOffsets[job + 1] = count;
+		});
+	for (std::size_t job = 0; job < jobs; ++job)
+		uniqueOffsets[job + 1] += uniqueOffsets[job];
+
+	std::vector<mth::float3> weldedPositions(uniqueOffsets[jobs]);
+	std::vector<std::uint32_t>& newIndices = hashes;
+	ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t job) {
+		std::size_t next = uniqueOffsets[job];
+		for (std::size_t i = jobBegin(job); i < jobBegin(job + 1); ++i)
+		{
+			if (firstOccurrence[i] == i)
+			{
+				newIndices[i] = static_cast<std::uint32_t>(next);
+				weldedPositions[next++] = vertices[i].position;
+			}
+		}
+		});
+
+	std::vector<std::uint32_t> weldedIndices(vertexCount);
+	std::vector<mth::float3> weldedNormals(vertexCount / 3);
+	ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t job) {
+		for (std::size_t i = jobBegin(job); i < jobBegin(job + 1); ++i)
+		{
+			weldedIndices[i] = newIndices[firstOccurrence[i]];
+			if (i % 3 == 0)
+				weldedNormals[i / 3] = vertices[i].normal;
+		}
+		});
+
+	mth::float3 boundsMin = weldedPositions.empty() ? mth::float3() : weldedPositions[0];
+	mth::float3 boundsMax = boundsMin;
+	for (const mth::float3& p : weldedPositions)
+	{
+		boundsMin.x = std::min(boundsMin.x, p.x);
+		boundsMin.y = std::min(boundsMin.y, p.y);
+		boundsMin.z = std::min(boundsMin.z, p.z);
+		boundsMax.x = std::max(boundsMax.x, p.x);
+		boundsMax.y = std::max(boundsMax.y, p.y);
+		boundsMax.z = std::max(boundsMax.z, p.z);
+	}
+
+	std::shared_ptr<Storage> storage = std::make_shared<Storage>();
+	storage->positions = std::move(weldedPositions);
+	storage->indices = std::move(weldedIndices);
+	storage->faceNormals = std::move(weldedNormals);
+	Clear();
+	positions = storage->positions;
+	indices = storage->indices;
+	faceNormals = storage->faceNormals;
+	m_storage = std::move(storage);
+	minCoords = boundsMin;
+	maxCoords = boundsMax;
+	return true;
+}
+
+void IndexedMesh::Attach(std::shared_ptr<const FileMapping> mapping, std::span<const mth::float3> mappedPositions, std::span<const std::uint32_t> mappedIndices, std::span<const mth::float3> mappedFaceNormals, mth::float3 boundsMin, mth::float3 boundsMax)
+{
+	Clear();
+	m_mapping = std::move(mapping);
+	positions = mappedPositions;
+	indices = mappedIndices;
+	faceNormals = mappedFaceNormals;
+	minCoords = boundsMin;
+	maxCoords = boundsMax;
+}
+
+void IndexedMesh::Clear()
+{
+	positions = {};
+	indices = {};
+	faceNormals = {};
+	minCoords = 0.0f;
+	maxCoords = 0.0f;
+	m_storage.reset();
+	m_mapping.reset();
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "math/position.hpp"
+#include <vector>
+#include <span>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+class FileMapping;
+
+struct Vertex
+{
+	mth::float3 position;
+	mth::float3 normal;
+};
+
+// The arrays are views, either into the owned storage or into a memory mapped mesh cache file.
+// Both are shared, so work running in the background can keep reading the arrays after the mesh is replaced.
+class IndexedMesh
+{
+	struct Storage
+	{
+		std::vector<mth::float3> positions;
+		std::vector<std::uint32_t> indices;
+		std::vector<mth::float3> faceNormals;
+	};
+
+	std::shared_ptr<const Storage> m_storage;
+	std::shared_ptr<const FileMapping> m_mapping;
+
+public:
+	std::span<const mth::float3> positions;
+	std::span<const std::uint32_t> indices;
+	std::span<const mth::float3> faceNormals;
+	mth::float3 minCoords;
+	mth::float3 maxCoords;
+
+public:
+	IndexedMesh() = default;
+	IndexedMesh(IndexedMesh&&) = default;
+	IndexedMesh(const IndexedMesh&) = delete;
+	IndexedMesh& operator=(IndexedMesh&&) = default;
+	IndexedMesh& operator=(const IndexedMesh&) = delete;
+
+	// merges bitwise equal corners of a triangle list, keeping the order of their first occurrence
+	bool Weld(const Vertex* vertices, std::size_t vertexCount);
+	void Attach(std::shared_ptr<const FileMapping> mapping, std::span<const mth::float3> mappedPositions, std::span<const std::uint32_t> mappedIndices, std::span<const mth::float3> mappedFaceNormals, mth::float3 boundsMin, mth::float3 boundsMax);
+	void Clear();
+
+	// keeps the arrays behind the views alive for as long as it is held, null for an empty mesh
+	inline std::shared_ptr<const void> Owner() const { return m_mapping ? std::shared_ptr<const void>(m_mapping) : std::shared_ptr<const void>(m_storage); }
+	inline std::size_t TriangleCount() const { return faceNormals.size(); }
+	inline const mth::float3& Position(std::size_t triangle, int corner) const { return positions[indices[3 * triangle + corner]]; }
+	// the largest absolute coordinate, every position is within it of the origin along each axis
+	inline float Magnitude() const { return std::max({ std::abs(minCoords.x), std::abs(minCoords.y), std::abs(minCoords.z), std::abs(maxCoords.x), std::abs(maxCoords.y), std::abs(maxCoords.z) }); }
+};
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "meshcache.h"
+#include "filemapping.h"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <random>
+
+static constexpr char s_magic[8] = { 'S', 'T', 'L', 'M', 'E', 'S', 'H', '\0' };
+static constexpr std::uint32_t s_version = 1;
+static constexpr std::uint64_t s_sectionAlignment = 64;
+
+enum class MeshCacheSectionType : std::uint32_t
+{
+	Positions = 1,
+	Indices = 2,
+	FaceNormals = 3
+};
+
+struct MeshCacheSection
+{
+	MeshCacheSectionType type;
+	std::uint32_t elementSize;
+	std::uint64_t offset;
+	std::uint64_t count;
+};
+
+struct MeshCacheHeader
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t sectionCount;
+	std::uint64_t sourceSize;
+	std::int64_t sourceWriteTime;
+	float minCoords[3];
+	float maxCoords[3];
+};
+
+static std::filesystem::path CacheFilename(const wchar_t* sourceFilename)
+{
+	std::filesystem::path path(sourceFilename);
+	path += L".meshcache";
+	return path;
+}
+
+static bool SourceStamp(const wchar_t* sourceFilename, std::uint64_t& size, std::int64_t& writeTime)
+{
+	std::error_code error;
+	size = std::filesystem::file_size(sourceFilename, error);
+	if (error)
+		return false;
+	writeTime = std::filesystem::last_write_time(sourceFilename, error).time_since_epoch().count();
+	return !error;
+}
+
+template <typename T>
+static bool FindSection(const FileMapping& file, const MeshCacheHeader& header, MeshCacheSectionType type, std::span<const T>& section)
+{
+	const char* table = file.Data() + sizeof(MeshCacheHeader);
+	for (std::uint32_t i = 0; i < header.sectionCount; ++i)
+	{
+		MeshCacheSection entry;
+		std::memcpy(&entry, table + i * sizeof(MeshCacheSection), sizeof(entry));
+		if (entry.type != type)
+			continue;
+		if (entry.elementSize != sizeof(T) || 0 != entry.offset % alignof(T) || entry.offset > file.Size() || entry.count > (file.Size() - entry.offset) / sizeof(T))
+			return false;
+		section = std::span<const T>(reinterpret_cast<const T*>(file.Data() + entry.offset), static_cast<std::size_t>(entry.count));
+		return true;
+	}
+	return false;
+}
+
+bool LoadMeshCache(const wchar_t* sourceFilename, IndexedMesh& mesh)
+{
+	std::uint64_t sourceSize;
+	std::int64_t sourceWriteTime;
+	if (!SourceStamp(sourceFilename, sourceSize, sourceWriteTime))
+		return false;
+
+	auto file = std::make_shared<FileMapping>();
+	if (!file->Open(CacheFilename(sourceFilename).wstring().c_str()) || file->Size() < sizeof(MeshCacheHeader))
+		return false;
+	MeshCacheHeader header;
+	std::memcpy(&header, file->Data(), sizeof(header));
+	if (0 != std::memcmp(header.magic, s_magic, sizeof(s_magic)) || s_version != header.version ||
+		sourceSize != header.sourceSize || sourceWriteTime != header.sourceWriteTime ||
+		header.sectionCount > (file->Size() - sizeof(MeshCacheHeader)) / sizeof(MeshCacheSection))
+		return false;
+
+	std::span<const mth::float3> positions;
+	std::span<const std::uint32_t> indices;
+	std::span<const mth::float3> faceNormals;
+	if (!FindSection(*file, header, MeshCacheSectionType::Positions, positions) ||
+		!FindSection(*file, header, MeshCacheSectionType::Indices, indices) ||
+		!FindSection(*file, header, MeshCacheSectionType::FaceNormals, faceNormals) ||
+		indices.size() != 3 * faceNormals.size())
+		return false;
+	// a damaged cache must not make the slicer read out of bounds
+	for (std::uint32_t index : indices)
+		if (index >= positions.size())
+			return false;
+
+	mesh.Attach(std::move(file), positions, indices, faceNormals, mth::float3(header.minCoords), mth::float3(header.maxCoords));
+	return true;
+}
+
+bool SaveMeshCache(const wchar_t* sourceFilename, const IndexedMesh& mesh)
+{
+	MeshCacheHeader header{};
+	std::memcpy(header.magic, s_magic, sizeof(s_magic));
+	header.version = s_version;
+	if (!SourceStamp(sourceFilename, header.sourceSize, header.sourceWriteTime))
+		return false;
+	std::memcpy(header.minCoords, &mesh.minCoords.x, sizeof(header.minCoords));
+	std::memcpy(header.maxCoords, &mesh.maxCoords.x, sizeof(header.maxCoords));
+
+	struct SectionData
+	{
+		MeshCacheSectionType type;
+		std::uint32_t elementSize;
+		const void* data;
+		std::uint64_t count;
+	};
+	const SectionData sections[] = {
+		{ MeshCacheSectionType::Positions, sizeof(mth::float3), mesh.positions.data(), mesh.positions.size() },
+		{ MeshCacheSectionType::Indices, sizeof(std::uint32_t), mesh.indices.data(), mesh.indices.size() },
+		{ MeshCacheSectionType::FaceNormals, sizeof(mth::float3), mesh.faceNormals.data(), mesh.faceNormals.size() }
+	};
+	header.sectionCount = static_cast<std::uint32_t>(std::size(sections));
+
+	MeshCacheSection table[std::size(sections)];
+	std::uint64_t offset = sizeof(MeshCacheHeader) + sizeof(table);
+	for (std::size_t i = 0; i < std::size(sections); ++i)
+	{
+		offset = (offset + s_sectionAlignment - 1) / s_sectionAlignment * s_sectionAlignment;
+		table[i] = { sections[i].type, sections[i].elementSize, offset, sections[i].count };
+		offset += sections[i].elementSize * sections[i].count;
+	}
+
+	// written under a temporary name, so a crash never leaves a half written cache behind,
+	// the name is unique so that imports of the same file running side by side do not write into each other
+	const std::filesystem::path cacheFilename = CacheFilename(sourceFilename);
+	std::random_device random;
+	std::filesystem::path tempFilename = cacheFilename;
+	tempFilename += L"." + std::to_wstring(random()) + std::to_wstring(random()) + L".tmp";
+	{
+		std::ofstream outfile(tempFilename, std::ios::binary | std::ios::trunc);
+		outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		outfile.write(reinterpret_cast<const char*>(table), sizeof(table));
+		for (std::size_t i = 0; i < std::size(sections); ++i)
+		{
+			const char padding[s_sectionAlignment]{};
+			outfile.write(padding, static_cast<std::streamsize>(table[i].offset - outfile.tellp()));
+			outfile.write(static_cast<const char*>(sections[i].data), static_cast<std::streamsize>(sections[i].elementSize * sections[i].count));
+		}
+		if (!outfile.good())
+		{
+			outfile.close();
+			std::error_code error;
+			std::filesystem::remove(tempFilename, error);
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(tempFilename, cacheFilename, error);
+	if (error)
+	{
+		std::filesystem::remove(tempFilename, error);
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "mesh.h"
+
+// Welded meshes are cached next to the source file ("part.stl" -> "part.stl.meshcache").
+// The cache is a header, a section table and 64 byte aligned arrays, so it can be used straight from a file mapping.
+// It is rebuilt when the size or the modification time of the source file changes.
+
+bool LoadMeshCache(const wchar_t* sourceFilename, IndexedMesh& mesh);
+bool SaveMeshCache(const wchar_t* sourceFilename, const IndexedMesh& mesh);
\ No newline at end of file
@@ -1,120 +1,186 @@
 #include "model.h"
-#include <string>
-#include <future>
-
-static mth::float3 StlConvert(mth::float3 v)
+#include "filemapping.h"
+#include "stlparser.h"
+#include "stlstream.h"
+#include "meshcache.h"
+#include "slicekernel.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+static constexpr std::size_t s_binFacetsPerJob = 1 << 16;
+static constexpr std::size_t s_textBytesPerJob = 1 << 20;
+static constexpr std::size_t s_progressFacets = 1 << 14;
+static constexpr std::size_t s_sliceTrianglesPerTask = 1 << 14;
+// a triangle whose normal leans at most this much (as a cosine) towards the plain normal runs parallel to it
+static constexpr float s_prismTolerance = 1e-6f;
+
+// reports the bytes processed since the previous call, false means the load has been cancelled
+static bool Advance(LoadProgress* progress, std::uint64_t bytes)
 {
-	return mth::float3(v.y, v.z, v.x);
+	if (nullptr == progress)
+		return true;
+	progress->Advance(bytes);
+	return !progress->IsCancelled();
 }
 
-static mth::float3 ReadF3Ascii(std::ifstream& infile)
+Model::Model()
+	: m_sliceIndices{ std::make_unique<SliceIndexCache>() }
+	, m_lazyData{ std::make_unique<LazyData>() }
+	, m_sliceCache{ std::make_unique<SliceCache>() } {}
+
+void Model::MeshChanged()
 {
-	mth::float3 v;
-	infile >> v;
-	return StlConvert(v);
+	m_sliceIndices->Clear();
+	m_lazyData = std::make_unique<LazyData>();
+	// slices closer than a millionth of the model size are taken as the same
+	m_sliceCache->Reset((m_mesh.maxCoords - m_mesh.minCoords).Length() * 1e-6f);
 }
 
-static mth::float3 ReadF3Bin(std::ifstream& infile)
+bool Model::SetVertices(const std::vector<Vertex>& vertices)
 {
-	mth::float3 v;
-	infile.read(reinterpret_cast<char*>(&v), sizeof(v));
-	return StlConvert(v);
+	IndexedMesh mesh;
+	if (!mesh.Weld(vertices.data(), vertices.size()))
+		return false;
+	m_mesh = std::move(mesh);
+	MeshChanged();
+	return true;
 }
 
-bool Model::LoadText(const wchar_t* filename)
+static StlTextResult ParseStlTextRange(std::vector<Vertex>& vertices, const char* begin, const char* end, LoadProgress* progress)
 {
-	std::ifstream infile(filename);
-	std::vector<Vertex> vertices;
-	std::string text;
-	std::getline(infile, text);	// first line indicating file type
-
-	while (!infile.eof())
+	const char* reported = begin;
+	Vertex facet[3];
+	while (true)
 	{
-		infile >> text;
-		if (text == "endsolid")
+		const StlTextResult result = ParseStlTextFacet(begin, end, facet);
+		if (StlTextResult::Facet != result)
 		{
-			m_vertices = std::move(vertices);
-			return true;
+			Advance(progress, static_cast<std::uint64_t>(begin - reported));
+			return result;
 		}
-		if (text != "facet")
-			return false;
-		infile >> text;
-		if (text != "normal")
-			return false;
-
-		Vertex v;
-		v.normal = ReadF3Ascii(infile);
+		vertices.insert(vertices.end(), facet, facet + 3);
+		if (vertices.size() % (3 * s_progressFacets) == 0)
+		{
+			if (!Advance(progress, static_cast<std::uint64_t>(begin - reported)))
+				return StlTextResult::Invalid;
+			reported = begin;
+		}
+	}
+}
 
-		infile >> text;
-		if (text != "outer")
-			return false;
-		infile >> text;
-		if (text != "loop")
+static bool DecodeStlBinRange(Vertex* output, const char* facets, std::size_t count, LoadProgress* progress)
+{
+	for (std::size_t first = 0; first < count; first += s_progressFacets)
+	{
+		const std::size_t batch = std::min(s_progressFacets, count - first);
+		DecodeStlBinFacets(output + 3 * first, facets + first * StlBinFacetSize, batch);
+		if (!Advance(progress, batch * StlBinFacetSize))
 			return false;
+	}
+	return true;
+}
 
-		infile >> text;
-		if (text != "vertex")
-			return false;
-		v.position = ReadF3Ascii(infile);
-		vertices.push_back(v);
+bool Model::LoadText(const char* data, std::size_t size, LoadProgress* progress)
+{
+	const char* end = data + size;
+	const char* begin = SkipStlTextHeader(data, end);	// first line indicating file type
+	const std::size_t jobs = std::min<std::size_t>(ThreadPool::Shared().ThreadCount() + 1, static_cast<std::size_t>(end - begin) / s_textBytesPerJob);
 
-		infile >> text;
-		if (text != "vertex")
+	if (jobs < 2)
+	{
+		std::vector<Vertex> vertices;
+		if (StlTextResult::EndSolid != ParseStlTextRange(vertices, begin, end, progress))
 			return false;
-		v.position = ReadF3Ascii(infile);
-		vertices.push_back(v);
+		return SetVertices(vertices);
+	}
 
-		infile >> text;
-		if (text != "vertex")
-			return false;
-		v.position = ReadF3Ascii(infile);
-		vertices.push_back(v);
+	// every range starts at a "facet" keyword, so no facet is split between two jobs
+	std::vector<const char*> bounds(jobs + 1);
+	bounds[0] = begin;
+	bounds[jobs] = end;
+	for (std::size_t i = 1; i < jobs; ++i)
+		bounds[i] = FindStlTextFacet(std::max(bounds[i - 1], begin + (end - begin) * i / jobs), end);
+
+	std::vector<std::vector<Vertex>> rangeVertices(jobs);
+	std::vector<StlTextResult> results(jobs);
+	ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t i) {
+		results[i] = ParseStlTextRange(rangeVertices[i], bounds[i], bounds[i + 1], progress);
+		});
 
-		infile >> text;
-		if (text != "endloop")
-			return false;
-		infile >> text;
-		if (text != "endfacet")
+	// ranges after the one holding "endsolid" are trailing garbage, every range before it has to be clean
+	std::size_t usedRanges = 0;
+	bool endSolid = false;
+	for (const StlTextResult result : results)
+	{
+		if (endSolid)
+			continue;
+		if (StlTextResult::EndSolid != result && StlTextResult::EndOfData != result)
 			return false;
+		endSolid = StlTextResult::EndSolid == result;
+		++usedRanges;
 	}
+	if (!endSolid)
+		return false;
+
+	std::vector<std::size_t> offsets(usedRanges + 1);
+	for (std::size_t i = 0; i < usedRanges; ++i)
+		offsets[i + 1] = offsets[i] + rangeVertices[i].size();
 
-	return false;
+	std::vector<Vertex> vertices(offsets[usedRanges]);
+	ThreadPool::Shared().ParallelFor(usedRanges, [&vertices, &rangeVertices, &offsets](std::size_t i) {
+		std::copy(rangeVertices[i].begin(), rangeVertices[i].end(), vertices.begin() + offsets[i]);
+		rangeVertices[i] = std::vector<Vertex>();
+		});
+
+	return SetVertices(vertices);
 }
 
-bool Model::LoadBin(const wchar_t* filename)
+bool Model::LoadBin(const char* data, std::size_t size, LoadProgress* progress)
 {
-	std::ifstream infile(filename, std::ios::binary);
-	char header[80];
-	infile.read(header, sizeof(header));
-	unsigned faceCount = 0;
-	infile.read(reinterpret_cast<char*>(&faceCount), sizeof(faceCount));
+	if (!IsBinaryStl(data, size))
+		return false;
+	const std::size_t faceCount = StlBinFaceCount(data);
+	const char* facets = data + StlBinHeaderSize;
 
-	std::vector<Vertex> vertices;
-	vertices.reserve(3 * faceCount);
-	for (unsigned i = 0; i < faceCount; ++i)
+	std::vector<Vertex> vertices(3 * faceCount);
+	const std::size_t jobs = std::min<std::size_t>(ThreadPool::Shared().ThreadCount() + 1, (faceCount + s_binFacetsPerJob - 1) / s_binFacetsPerJob);
+	if (jobs < 2)
 	{
-		Vertex v;
-		v.normal = ReadF3Bin(infile);
-		v.position = ReadF3Bin(infile);
-		vertices.push_back(v);
-		v.position = ReadF3Bin(infile);
-		vertices.push_back(v);
-		v.position = ReadF3Bin(infile);
-		vertices.push_back(v);
-
-		if (infile.eof())
+		if (!DecodeStlBinRange(vertices.data(), facets, faceCount, progress))
+			return false;
+	}
+	else
+	{
+		const std::size_t jobWorkCount = (faceCount + jobs - 1) / jobs;
+		std::atomic<bool> decoded = true;
+		ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t job) {
+			const std::size_t first = std::min(faceCount, job * jobWorkCount);
+			const std::size_t count = std::min(jobWorkCount, faceCount - first);
+			if (!DecodeStlBinRange(&vertices[3 * first], facets + first * StlBinFacetSize, count, progress))
+				decoded = false;
+			});
+		if (!decoded)
 			return false;
-		char attr[2];
-		infile.read(attr, sizeof(attr));
 	}
 
-	m_vertices = std::move(vertices);
-	return true;
+	return SetVertices(vertices);
+}
+
+bool Model::LoadCompressed(const char* data, std::size_t size, LoadProgress* progress)
+{
+	std::vector<Vertex> vertices;
+	if (!ParseCompressedStl(data, size, vertices, progress))
+		return false;
+	return SetVertices(vertices);
 }
 
 void Model::Cube()
 {
-	m_vertices = std::vector<Vertex>({
+	SetVertices(std::vector<Vertex>({
 		// bottom
 		{ mth::float3(-1.0f, -1.0f, -1.0f), mth::float3( 0.0f, -1.0f,  0.0f) },
 		{ mth::float3( 1.0f, -1.0f, -1.0f), mth::float3( 0.0f, -1.0f,  0.0f) },
@@ -157,130 +223,403 @@ void Model::Cube()
 		{ mth::float3( 1.0f, -1.0f,  1.0f), mth::float3( 0.0f,  0.0f,  1.0f) },
 		{ mth::float3( 1.0f,  1.0f,  1.0f), mth::float3( 0.0f,  0.0f,  1.0f) },
 		{ mth::float3(-1.0f, -1.0f,  1.0f), mth::float3( 0.0f,  0.0f,  1.0f) }
-		});
+		}));
 }
 
-bool Model::Load(const wchar_t* filename)
+bool Model::Load(const wchar_t* filename, LoadProgress* progress)
 {
-	std::ifstream infile(filename);
-	if (!infile.is_open())
+	IndexedMesh cachedMesh;
+	if (LoadMeshCache(filename, cachedMesh))
+	{
+		m_mesh = std::move(cachedMesh);
+		MeshChanged();
+		return true;
+	}
+
+	FileMapping file;
+	if (!file.Open(filename))
 		return false;
+	if (progress)
+		progress->AddTotal(file.FileSize());
 
-	char solid[5];
-	infile.read(solid, sizeof(solid));
-	infile.close();
-	if (0 == std::memcmp(solid, "solid", 5))
-		return LoadText(filename);
-	return LoadBin(filename);
+	bool loaded = false;
+	switch (DetectStlCompression(file.Data(), file.Size()))
+	{
+	case StlCompression::None:
+		loaded = IsBinaryStl(file.Data(), file.Size()) ? LoadBin(file.Data(), file.Size(), progress) : LoadText(file.Data(), file.Size(), progress);
+		break;
+	case StlCompression::Gzip:
+		loaded = LoadCompressed(file.Data(), file.Size(), progress);
+		break;
+	case StlCompression::Zstd:	// recognized so it is not mistaken for a binary STL, but not decoded
+		break;
+	}
+	if (loaded)
+		SaveMeshCache(filename, m_mesh);
+	return loaded;
 }
 
 void Model::OptimalPositioning(mth::float3& offset, float& scale) const
 {
-	if (m_vertices.empty())
+	if (m_mesh.positions.empty())
 	{
 		offset = 0.0f;
 		scale = 1.0f;
 	}
 	else
 	{
-		mth::float3 minCoords = m_vertices[0].position;
-		mth::float3 maxCoords = minCoords;
-		for (const Vertex& v : m_vertices)
-		{
-			minCoords.x = std::min(minCoords.x, v.position.x);
-			minCoords.y = std::min(minCoords.y, v.position.y);
-			minCoords.z = std::min(minCoords.z, v.position.z);
-			maxCoords.x = std::max(maxCoords.x, v.position.x);
-			maxCoords.y = std::max(maxCoords.y, v.position.y);
-			maxCoords.z = std::max(maxCoords.z, v.position.z);
-		}
-		offset = (maxCoords - minCoords) * 0.5f + minCoords;
-		scale = 1.0f / (maxCoords - minCoords).Length();
+		offset = (m_mesh.maxCoords - m_mesh.minCoords) * 0.5f + m_mesh.minCoords;
+		scale = 1.0f / (m_mesh.maxCoords - m_mesh.minCoords).Length();
 	}
 }
 
-static void CalculateTriangleSlice(std::vector<mth::float2>& outputContainer, const mth::float3x3& plainTransform, float plainDistFromOrigin, const Vertex vertices[3])
+std::shared_ptr<const SliceIndex> Model::SliceIndexFor(mth::float3 plainNormal) const
 {
-	mth::float3 v[] = {
-		plainTransform * vertices[0].position - mth::float3(0.0f, plainDistFromOrigin, 0.0f),
-		plainTransform * vertices[1].position - mth::float3(0.0f, plainDistFromOrigin, 0.0f),
-		plainTransform * vertices[2].position - mth::float3(0.0f, plainDistFromOrigin, 0.0f)
-	};
-	for (int i = 0; i < 3; ++i)
-		if (0.0f == v[i].y)
-			v[i].y = std::numeric_limits<float>::min();
-
-	if (v[0].y * v[1].y < 0.0f)
-		outputContainer.push_back(mth::float2(v[0].x, v[0].z) + mth::float2(v[1].x - v[0].x, v[1].z - v[0].z) * std::abs(v[0].y / (v[1].y - v[0].y)));
-	if (v[1].y * v[2].y < 0.0f)
-		outputContainer.push_back(mth::float2(v[1].x, v[1].z) + mth::float2(v[2].x - v[1].x, v[2].z - v[1].z) * std::abs(v[1].y / (v[2].y - v[1].y)));
-	if (v[2].y * v[0].y < 0.0f)
-		outputContainer.push_back(mth::float2(v[2].x, v[2].z) + mth::float2(v[0].x - v[2].x, v[0].z - v[2].z) * std::abs(v[2].y / (v[0].y - v[2].y)));
+	return m_sliceIndices->Find(m_mesh, plainNormal);
 }
 
-std::vector<mth::float2> Model::CalcSlice(mth::float3 plainNormal, float plainDistFromOrigin) const
+std::vector<mth::float2> Model::CalcIndexedSlice(const SliceIndex& index, float plainDistFromOrigin) const
 {
+	std::vector<std::uint32_t> triangles;
+	index.Query(plainDistFromOrigin, triangles);
+	std::sort(triangles.begin(), triangles.end());	// same segment order as the full pass
+
+	const mth::float3x3 plainTransform = PlainTransform(index.PlainNormal());
 	std::vector<mth::float2> slice;
-	slice.reserve(m_vertices.size() / 3 * 2);
+	slice.reserve(triangles.size() * 2);
+	for (std::uint32_t i : triangles)
+		CalculateTriangleSlice(slice, plainTransform, plainDistFromOrigin, m_mesh.Position(i, 0), m_mesh.Position(i, 1), m_mesh.Position(i, 2));
+	return slice;
+}
+
+// The value is built outside the lock, so a build waiting for its pool tasks never blocks a task that needs the same value,
+// two threads asking at once may both build it and the first one to finish is kept.
+template <typename T, typename Build>
+static const T& BuildOnce(std::mutex& mutex, std::unique_ptr<T>& value, Build build)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (value)
+			return *value;
+	}
+	std::unique_ptr<T> built = build();
+	std::lock_guard<std::mutex> lock(mutex);
+	if (nullptr == value)
+		value = std::move(built);
+	return *value;
+}
 
-	const mth::float3x3 plainTransform = mth::float3x3::RotateUnitVector(plainNormal, mth::float3(0.0f, 1.0f, 0.0f));
+const TriangleSoA& Model::Triangles() const
+{
+	return BuildOnce(m_lazyData->mutex, m_lazyData->triangleSoA, [this]() { return std::make_unique<TriangleSoA>(m_mesh); });
+}
 
-	for (std::size_t i = 0; i < m_vertices.size(); i += 3)
-		CalculateTriangleSlice(slice, plainTransform, plainDistFromOrigin, m_vertices.data() + i);
+const EdgeTable& Model::Edges() const
+{
+	return BuildOnce(m_lazyData->mutex, m_lazyData->edgeTable, [this]() { return std::make_unique<EdgeTable>(m_mesh); });
+}
 
+std::vector<mth::float2> Model::CalcFullSlice(mth::float3 plainNormal, float plainDistFromOrigin) const
+{
+	const TriangleSoA& triangles = Triangles();
+	std::vector<mth::float2> slice(SliceOutputCapacity(triangles.Count()));
+	slice.resize(SliceTriangles(triangles, PlainTransform(plainNormal), plainDistFromOrigin, 0, triangles.Count(), slice.data()));
 	return slice;
 }
 
+std::vector<mth::float2> Model::CalcSlice(mth::float3 plainNormal, float plainDistFromOrigin) const
+{
+	return CalcSlice(plainNormal, plainDistFromOrigin, 1);
+}
+
 std::vector<mth::float2> Model::CalcSlice(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs) const
 {
+	if (const std::shared_ptr<const SliceIndex> index = SliceIndexFor(plainNormal))
+		return CalcIndexedSlice(*index, plainDistFromOrigin);
 	if (jobs < 2)
-		return CalcSlice(plainNormal, plainDistFromOrigin);
+		return CalcFullSlice(plainNormal, plainDistFromOrigin);
+
+	// many more tasks than jobs, so a slow thread does not hold up the whole slice
+	const TriangleSoA& triangles = Triangles();
+	const mth::float3x3 plainTransform = PlainTransform(plainNormal);
+	const std::size_t taskCount = std::max<std::size_t>(jobs, (triangles.Count() + s_sliceTrianglesPerTask - 1) / s_sliceTrianglesPerTask);
+	const std::size_t taskWorkCount = (triangles.Count() + taskCount - 1) / taskCount;
+	auto taskRange = [&triangles, taskWorkCount](std::size_t task, std::size_t& first, std::size_t& count) {
+		first = std::min(triangles.Count(), task * taskWorkCount);
+		count = std::min(taskWorkCount, triangles.Count() - first);
+	};
+
+	// the points of every task are counted first, so all tasks can write straight into the final slice
+	std::vector<std::size_t> offsets(taskCount + 1);
+	ThreadPool::Shared().ParallelFor(taskCount, [&](std::size_t task) {
+		std::size_t first, count;
+		taskRange(task, first, count);
+		offsets[task + 1] = CountSliceTriangles(triangles, plainTransform, plainDistFromOrigin, first, count);
+		});
+	for (std::size_t task = 0; task < taskCount; ++task)
+		offsets[task + 1] += offsets[task];
+
+	std::vector<mth::float2> slice(offsets[taskCount]);
+	ThreadPool::Shared().ParallelFor(taskCount, [&](std::size_t task) {
+		std::size_t first, count;
+		taskRange(task, first, count);
+		SliceTrianglesExact(triangles, plainTransform, plainDistFromOrigin, first, count, slice.data() + offsets[task], offsets[task + 1] - offsets[task]);
+		});
+	return slice;
+}
+
+ContourSet Model::CalcContours(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs) const
+{
+	ContourSet contours;
+	if (m_sliceCache->Find(plainNormal, plainDistFromOrigin, contours))
+		return contours;
+	contours = CalcUncachedContours(plainNormal, plainDistFromOrigin, jobs);
+	m_sliceCache->Insert(plainNormal, plainDistFromOrigin, contours);
+	return contours;
+}
+
+ContourSet Model::CalcUncachedContours(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs) const
+{
+	if (const std::shared_ptr<const SliceIndex> index = SliceIndexFor(plainNormal))
+	{
+		const mth::float3x3 plainTransform = PlainTransform(plainNormal);
+		std::vector<std::uint32_t> triangles;
+		index->Query(plainDistFromOrigin, triangles);
+		std::vector<EdgeSegment> segments;
+		segments.reserve(triangles.size());
+		for (std::uint32_t i : triangles)
+		{
+			EdgeSegment segment;
+			if (CalculateEdgeSegment(segment, m_mesh, i, plainTransform, plainDistFromOrigin))
+				segments.push_back(segment);
+		}
+		return JoinSegments(segments);
+	}
+
+	// without an index every edge is visited anyway, so each crossed one is cut only once
+	return JoinEdgeSlice(CalcEdgeSlice(plainNormal, plainDistFromOrigin, jobs));
+}
+
+const GridMesh* Model::Grid() const
+{
+	const GridMesh& gridMesh = BuildOnce(m_lazyData->mutex, m_lazyData->gridMesh, [this]() {
+		std::unique_ptr<GridMesh> gridMesh = std::make_unique<GridMesh>();
+		gridMesh->Quantize(m_mesh);
+		return gridMesh;
+		});
+	return gridMesh.Positions().size() == m_mesh.positions.size() ? &gridMesh : nullptr;
+}
+
+bool Model::CalcGridContours(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs, GridContourSet& contours) const
+{
+	const PlainAxis axis = PlainAxisOf(PlainTransform(plainNormal));
+	const GridMesh* grid = Grid();
+	if (PlainAxis::Rotated == axis || nullptr == grid)
+		return false;
+	const std::int64_t plainDistance = grid->ToGrid(plainDistFromOrigin);
+
+	jobs = std::max(1u, jobs);
+	const std::size_t jobWorkCount = (m_mesh.TriangleCount() + jobs - 1) / jobs;
+	std::vector<std::vector<GridSegment>> jobSegments(jobs);
+	ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t job) {
+		const std::size_t first = std::min(m_mesh.TriangleCount(), job * jobWorkCount);
+		const std::size_t last = std::min(m_mesh.TriangleCount(), first + jobWorkCount);
+		GridSegment segment;
+		for (std::size_t i = first; i < last; ++i)
+			if (CalculateGridSegment(segment, *grid, m_mesh, i, axis, plainDistance))
+				jobSegments[job].push_back(segment);
+		});
+	std::vector<GridSegment> segments;
+	for (std::vector<GridSegment>& part : jobSegments)
+		segments.insert(segments.end(), part.begin(), part.end());
+	contours = JoinSegments(segments);
+	return true;
+}
+
+EdgeSlice Model::CalcEdgeSlice(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs) const
+{
+	return SliceEdges(Edges(), m_mesh, PlainTransform(plainNormal), plainDistFromOrigin, jobs);
+}
+
+SliceStack Model::CalcSliceStack(mth::float3 plainNormal, float firstPlainDistance, float layerDistance, unsigned layerCount, unsigned jobs) const
+{
+	if (!(layerDistance > 0.0f))
+		layerCount = 0;
+	std::vector<float> plainDistances(layerCount);
+	for (unsigned layer = 0; layer < layerCount; ++layer)
+		plainDistances[layer] = firstPlainDistance + layerDistance * static_cast<float>(layer);
+	return CalcSlices(plainNormal, plainDistances, jobs);
+}
 
-	class Worker
+SliceStack Model::CalcSlices(mth::float3 plainNormal, std::span<const float> plainDistances, unsigned jobs) const
+{
+	SliceStack stack;
+	stack.shapeOffsets.push_back(0);
+
+	// the layers are swept in ascending order, a NaN distance cuts nothing
+	std::vector<std::uint32_t> order;
+	order.reserve(plainDistances.size());
+	for (std::size_t i = 0; i < plainDistances.size(); ++i)
+		if (!std::isnan(plainDistances[i]))
+			order.push_back(static_cast<std::uint32_t>(i));
+	std::stable_sort(order.begin(), order.end(), [plainDistances](std::uint32_t a, std::uint32_t b) { return plainDistances[a] < plainDistances[b]; });
+	const unsigned layerCount = static_cast<unsigned>(order.size());
+	if (0 == layerCount)
 	{
-		const mth::float3x3& m_plainTransform;
-		const float m_plainDistFromOrigin;
-		std::vector<mth::float2> m_slice;
-		std::future<void> m_future;
+		if (!plainDistances.empty())
+			stack.shapeOffsets.push_back(0);
+		stack.layerShapes.assign(plainDistances.size(), 0);
+		return stack;
+	}
+	std::vector<float> distances(layerCount);
+	for (unsigned layer = 0; layer < layerCount; ++layer)
+		distances[layer] = plainDistances[order[layer]];
 
-	public:
-		Worker(const mth::float3x3& plainTransform, const float plainDistFromOrigin)
-			: m_plainTransform(plainTransform)
-			, m_plainDistFromOrigin(plainDistFromOrigin) {}
+	// every vertex is moved into the plain frame once and shared by all layers
+	const mth::float3x3 plainTransform = PlainTransform(plainNormal);
+	std::vector<mth::float3> frame(m_mesh.positions.size());
+	{
+		const std::size_t transformJobs = std::max(1u, jobs);
+		const std::size_t jobWorkCount = (frame.size() + transformJobs - 1) / transformJobs;
+		ThreadPool::Shared().ParallelFor(transformJobs, [&](std::size_t job) {
+			const std::size_t first = std::min(frame.size(), job * jobWorkCount);
+			const std::size_t last = std::min(frame.size(), first + jobWorkCount);
+			for (std::size_t i = first; i < last; ++i)
+				frame[i] = plainTransform * m_mesh.positions[i];
+			});
+	}
 
-		void Run(const Vertex* vertices, unsigned count)
+	// a triangle is cut by the layers with minHeight < d <= maxHeight, the same test the kernel makes corner by corner,
+	// widened by the rounding error of the heights, where the kernel decides the side of a corner more precisely,
+	// start events are grouped by layer with a counting sort, which keeps triangle order inside a layer
+	const float heightError = PlainHeightError(plainTransform, m_mesh.Magnitude());
+	const std::size_t triangleCount = m_mesh.TriangleCount();
+	std::vector<unsigned> firstLayers(triangleCount);
+	std::vector<unsigned> lastLayers(triangleCount);
+	std::vector<std::size_t> startOffsets(static_cast<std::size_t>(layerCount) + 1);
+	std::vector<unsigned> endCounts(layerCount);
+	std::vector<int> slantedChanges(static_cast<std::size_t>(layerCount) + 1);
+	for (std::size_t i = 0; i < triangleCount; ++i)
+	{
+		const mth::float3& v0 = frame[m_mesh.indices[3 * i + 0]];
+		const mth::float3& v1 = frame[m_mesh.indices[3 * i + 1]];
+		const mth::float3& v2 = frame[m_mesh.indices[3 * i + 2]];
+		firstLayers[i] = layerCount;
+		if (std::isnan(v0.y + v1.y + v2.y))
+			continue;
+		const unsigned first = static_cast<unsigned>(std::upper_bound(distances.begin(), distances.end(), std::min({ v0.y, v1.y, v2.y }) - heightError) - distances.begin());
+		const unsigned end = static_cast<unsigned>(std::upper_bound(distances.begin(), distances.end(), std::max({ v0.y, v1.y, v2.y }) + heightError) - distances.begin());
+		if (first < end)
 		{
-			m_slice.reserve(count * 2);
-			m_future = std::async([this](const Vertex* vertices, unsigned count) {
-				for (unsigned i = 0; i < count; ++i)
-					CalculateTriangleSlice(m_slice, m_plainTransform, m_plainDistFromOrigin, &vertices[i * 3]);
-				}, vertices, count);
+			firstLayers[i] = first;
+			lastLayers[i] = end - 1;
+			++startOffsets[first + 1];
+			++endCounts[end - 1];
+			const mth::float3 normal = (v1 - v0).Cross(v2 - v0);
+			if (std::abs(normal.y) > s_prismTolerance * normal.Length())
+			{
+				++slantedChanges[first];
+				--slantedChanges[end];
+			}
 		}
+	}
+	for (unsigned layer = 0; layer < layerCount; ++layer)
+		startOffsets[layer + 1] += startOffsets[layer];
+	std::vector<std::uint32_t> byStart(startOffsets[layerCount]);
+	{
+		std::vector<std::size_t> cursors(startOffsets.begin(), startOffsets.end() - 1);
+		for (std::size_t i = 0; i < triangleCount; ++i)
+			if (firstLayers[i] < layerCount)
+				byStart[cursors[firstLayers[i]]++] = static_cast<std::uint32_t>(i);
+	}
 
-		void GetSlices(std::vector<mth::float2>& outputContainer)
+	// When nothing starts or ends between two layers and every triangle they cut runs parallel to the normal,
+	// the solid is a prism there and the upper layer shares the cross-section of the lower one instead of being sliced again.
+	std::vector<std::uint32_t> layerShapes(layerCount);
+	std::vector<unsigned> shapeLayers;	// the layer every shape is sliced at
+	int slanted = 0;
+	for (unsigned layer = 0; layer < layerCount; ++layer)
+	{
+		slanted += slantedChanges[layer];
+		const bool repeat = 0 < layer && (distances[layer] == distances[layer - 1] ||
+			(startOffsets[layer] == startOffsets[layer + 1] && 0 == endCounts[layer - 1] && 0 == slanted));
+		if (!repeat)
+			shapeLayers.push_back(layer);
+		layerShapes[layer] = static_cast<std::uint32_t>(shapeLayers.size() - 1);
+	}
+	const unsigned shapeCount = static_cast<unsigned>(shapeLayers.size());
+
+	// every job sweeps its own range of shapes, the active set stays in triangle order,
+	// so each shape lists its segments in the same order as CalcSlice
+	jobs = std::clamp(jobs, 1u, shapeCount);
+	auto jobShapes = [shapeCount, jobs](std::size_t job, unsigned& beginShape, unsigned& endShape) {
+		beginShape = static_cast<unsigned>(static_cast<std::uint64_t>(shapeCount) * job / jobs);
+		endShape = static_cast<unsigned>(static_cast<std::uint64_t>(shapeCount) * (job + 1) / jobs);
+	};
+	std::vector<std::vector<mth::float2>> jobPoints(jobs);
+	std::vector<std::size_t> shapeEnds(shapeCount);	// relative to the job
+	auto sweep = [&](std::size_t job) {
+		unsigned beginShape, endShape;
+		jobShapes(job, beginShape, endShape);
+		std::vector<mth::float2>& points = jobPoints[job];
+		auto frameCorner = [&](std::uint32_t vertex, float plainDistFromOrigin) {
+			mth::float3 v = frame[vertex];
+			v.y = PlainRelativeHeight(plainTransform, plainDistFromOrigin, m_mesh.positions[vertex], v.y);
+			return v;
+		};
+
+		const unsigned beginLayer = shapeLayers[beginShape];
+		std::vector<std::uint32_t> active;
+		for (std::size_t i = 0; i < startOffsets[beginLayer]; ++i)
+			if (lastLayers[byStart[i]] >= beginLayer)
+				active.push_back(byStart[i]);
+		std::sort(active.begin(), active.end());
+
+		// nothing starts on a repeated layer, so only the sliced ones have to update the active set
+		std::size_t pointCount = 0;
+		for (unsigned shape = beginShape; shape < endShape; ++shape)
 		{
-			m_future.wait();
-			outputContainer.insert(outputContainer.end(), m_slice.begin(), m_slice.end());
+			const unsigned layer = shapeLayers[shape];
+			active.erase(std::remove_if(active.begin(), active.end(), [&lastLayers, layer](std::uint32_t i) { return lastLayers[i] < layer; }), active.end());
+			const std::size_t started = active.size();
+			active.insert(active.end(), byStart.begin() + startOffsets[layer], byStart.begin() + startOffsets[layer + 1]);
+			std::inplace_merge(active.begin(), active.begin() + started, active.end());
+
+			points.resize(pointCount + 3 * active.size());
+			for (std::uint32_t i : active)
+			{
+				const std::uint32_t* corners = &m_mesh.indices[3 * static_cast<std::size_t>(i)];
+				const float distance = distances[layer];
+				pointCount += CalculateFrameTriangleSlice(points.data() + pointCount, frameCorner(corners[0], distance), frameCorner(corners[1], distance), frameCorner(corners[2], distance));
+			}
+			shapeEnds[shape] = pointCount;
 		}
+		points.resize(pointCount);
 	};
+	ThreadPool::Shared().ParallelFor(jobs, sweep);
 
-	std::size_t jobWorkCount = (m_vertices.size() / 3 + jobs - 1) / jobs;
-	const mth::float3x3 plainTransform = mth::float3x3::RotateUnitVector(plainNormal, mth::float3(0.0f, 1.0f, 0.0f));
-	std::vector<Worker> workers;
-	workers.reserve(jobs);
-
-	for (unsigned i = 0; i < jobs; ++i)
+	// layers with a NaN distance show an extra empty shape, the rest go back to the order their distances were given in
+	stack.shapeOffsets.resize(static_cast<std::size_t>(shapeCount) + 1 + (layerCount < plainDistances.size() ? 1 : 0));
+	for (std::size_t job = 0; job < jobs; ++job)
 	{
-		if (m_vertices.size() <= i * jobWorkCount * 3)
-			break;
-		const Vertex* vertices = &m_vertices[3 * i * jobWorkCount];
-		unsigned count = std::min(jobWorkCount, m_vertices.size() / 3 - i * jobWorkCount);
-		workers.emplace_back(plainTransform, plainDistFromOrigin).Run(vertices, count);
+		unsigned beginShape, endShape;
+		jobShapes(job, beginShape, endShape);
+		for (unsigned shape = beginShape; shape < endShape; ++shape)
+			stack.shapeOffsets[shape + 1] = shapeEnds[shape] - (shape == beginShape ? 0 : shapeEnds[shape - 1]);
 	}
-
-	std::vector<mth::float2> allSlice;
-	allSlice.reserve(m_vertices.size() / 3 * 2);
-	for (Worker& w : workers)
-		w.GetSlices(allSlice);
-	return allSlice;
-}
+	for (std::size_t shape = 1; shape < stack.shapeOffsets.size(); ++shape)
+		stack.shapeOffsets[shape] += stack.shapeOffsets[shape - 1];
+	stack.layerShapes.assign(plainDistances.size(), shapeCount);
+	for (unsigned layer = 0; layer < layerCount; ++layer)
+		stack.layerShapes[order[layer]] = layerShapes[layer];
+
+	stack.points.resize(stack.shapeOffsets.back());
+	ThreadPool::Shared().ParallelFor(jobs, [&](std::size_t job) {
+		unsigned beginShape, endShape;
+		jobShapes(job, beginShape, endShape);
+		if (beginShape < endShape)
+			std::copy(jobPoints[job].begin(), jobPoints[job].end(), stack.points.begin() + stack.shapeOffsets[beginShape]);
+		jobPoints[job] = std::vector<mth::float2>();
+		});
+	return stack;
+}
\ No newline at end of file
@@ -1,30 +1,77 @@
 #pragma once
 
-#include "math/position.hpp"
+#include "mesh.h"
+#include "loadprogress.h"
+#include "sliceindexcache.h"
+#include "slicestack.h"
+#include "contour.h"
+#include "slicesimd.h"
+#include "slicecache.h"
+#include "edgetable.h"
+#include "gridmesh.h"
 #include <vector>
-#include <fstream>
-
-struct Vertex
-{
-	mth::float3 position;
-	mth::float3 normal;
-};
+#include <memory>
+#include <span>
+#include <mutex>
 
 class Model
 {
-	std::vector<Vertex> m_vertices;
+	// built on first use by whichever thread needs them first, replaced as a whole when the mesh changes
+	struct LazyData
+	{
+		std::mutex mutex;
+		std::unique_ptr<TriangleSoA> triangleSoA;
+		std::unique_ptr<EdgeTable> edgeTable;
+		std::unique_ptr<GridMesh> gridMesh;
+	};
+
+	IndexedMesh m_mesh;
+	std::unique_ptr<SliceIndexCache> m_sliceIndices;
+	std::unique_ptr<LazyData> m_lazyData;
+	std::unique_ptr<SliceCache> m_sliceCache;
 
 private:
-	bool LoadText(const wchar_t* filename);
-	bool LoadBin(const wchar_t* filename);
+	void MeshChanged();
+	std::shared_ptr<const SliceIndex> SliceIndexFor(mth::float3 plainNormal) const;
+	const TriangleSoA& Triangles() const;
+	std::vector<mth::float2> CalcIndexedSlice(const SliceIndex& index, float plainDistFromOrigin) const;
+	std::vector<mth::float2> CalcFullSlice(mth::float3 plainNormal, float plainDistFromOrigin) const;
+	ContourSet CalcUncachedContours(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs) const;
+	bool SetVertices(const std::vector<Vertex>& vertices);
+	bool LoadText(const char* data, std::size_t size, LoadProgress* progress);
+	bool LoadBin(const char* data, std::size_t size, LoadProgress* progress);
+	bool LoadCompressed(const char* data, std::size_t size, LoadProgress* progress);
 
 public:
+	Model();
+
 	void Cube();
-	bool Load(const wchar_t* filename);
+	bool Load(const wchar_t* filename, LoadProgress* progress = nullptr);
 
 	void OptimalPositioning(mth::float3& offset, float& scale) const;
 	std::vector<mth::float2> CalcSlice(mth::float3 plainNormal, float plainDistFromOrigin) const;
 	std::vector<mth::float2> CalcSlice(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs) const;
+	ContourSet CalcContours(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs) const;
+	// cuts every crossed edge once, the segments refer to the points of Edges()
+	EdgeSlice CalcEdgeSlice(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs) const;
+	// Cuts on the integer grid of Grid() with the plain distance rounded to the grid, so end points match exactly.
+	// False unless the normal lies along a coordinate axis and the mesh fits the grid.
+	bool CalcGridContours(mth::float3 plainNormal, float plainDistFromOrigin, unsigned jobs, GridContourSet& contours) const;
+	// slices layers firstPlainDistance + i * layerDistance in one sweep along the normal
+	SliceStack CalcSliceStack(mth::float3 plainNormal, float firstPlainDistance, float layerDistance, unsigned layerCount, unsigned jobs) const;
+	// layer i of the stack is cut at plainDistances[i], the distances may come in any order,
+	// the vertices are moved into the plain frame once for the whole batch,
+	// a layer where the part is a prism down to the layer below shares the shape of that layer
+	SliceStack CalcSlices(mth::float3 plainNormal, std::span<const float> plainDistances, unsigned jobs) const;
 
-	inline const std::vector<Vertex>& Vertices() const { return m_vertices; }
+	inline const IndexedMesh& Mesh() const { return m_mesh; }
+	// the slice indices CalcSlice and CalcContours use, cleared whenever the mesh changes, the viewer's slice session shares them
+	inline SliceIndexCache& SliceIndices() const { return *m_sliceIndices; }
+	// built on first use and dropped whenever the mesh changes, safe to call from several threads
+	const EdgeTable& Edges() const;
+	// quantized with the default step on first use and dropped whenever the mesh changes, null if the mesh does not fit the grid,
+	// safe to call from several threads
+	const GridMesh* Grid() const;
+	// results of CalcContours, cleared whenever the mesh changes, the viewer keeps the contours of its slice session here too
+	inline SliceCache& Cache() const { return *m_sliceCache; }
 };
\ No newline at end of file
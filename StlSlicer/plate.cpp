@@ -0,0 +1,55 @@
+#include "plate.h"
+#include "threadpool.h"
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+
+static void LoadPart(PlatePart& part, LoadProgress* progress)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	part.loaded = false;
+	try
+	{
+		if (progress && progress->IsCancelled())
+			part.error = "Cancelled";
+		else if (part.model.Load(part.filename.c_str(), progress))
+			part.loaded = true;
+		else
+			part.error = progress && progress->IsCancelled() ? "Cancelled" : "Not a valid STL file";
+	}
+	catch (const std::exception& ex)
+	{
+		part.error = ex.what();
+	}
+	part.loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::size_t Plate::Import(const std::vector<std::wstring>& filenames, LoadProgress* progress)
+{
+	const std::size_t first = m_parts.size();
+	m_parts.resize(first + filenames.size());
+
+	// largest first, small parts fill the gaps while the big ones finish
+	std::vector<std::pair<std::uintmax_t, std::size_t>> order;
+	order.reserve(filenames.size());
+	for (std::size_t i = 0; i < filenames.size(); ++i)
+	{
+		m_parts[first + i].filename = filenames[i];
+		std::error_code error;
+		const std::uintmax_t size = std::filesystem::file_size(filenames[i], error);
+		order.emplace_back(error ? 0 : size, first + i);
+	}
+	std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	// indices are handed out in order, the parsing inside every load is spread over the pool too
+	ThreadPool::Shared().ParallelFor(order.size(), [this, &order, progress](std::size_t i) {
+		LoadPart(m_parts[order[i].second], progress);
+		});
+
+	return static_cast<std::size_t>(std::count_if(m_parts.begin() + first, m_parts.end(), [](const PlatePart& part) { return part.loaded; }));
+}
+
+void Plate::Clear()
+{
+	m_parts.clear();
+}
\ No newline at end of file
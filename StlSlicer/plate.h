@@ -0,0 +1,29 @@
+#pragma once
+
+#include "model.h"
+#include "loadprogress.h"
+#include <string>
+#include <vector>
+
+struct PlatePart
+{
+	std::wstring filename;
+	Model model;
+	bool loaded;
+	double loadSeconds;
+	std::string error;
+};
+
+// The parts of a build plate, every file is loaded into a model of its own.
+class Plate
+{
+	std::vector<PlatePart> m_parts;
+
+public:
+	// Loads the files concurrently, the largest first, so a plate takes about as long as its largest part.
+	// Parts that fail keep their slot with the reason, the return value is the number of parts loaded.
+	std::size_t Import(const std::vector<std::wstring>& filenames, LoadProgress* progress = nullptr);
+	void Clear();
+
+	inline const std::vector<PlatePart>& Parts() const { return m_parts; }
+};
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "slicecache.h"
+#include <cmath>
+
+static constexpr double s_normalSteps = 1 << 20;	// per unit of a normal component
+
+std::size_t SliceCache::KeyHash::operator()(const Key& key) const
+{
+	std::uint64_t h = static_cast<std::uint64_t>(key.distance) * 0x9e3779b97f4a7c15ull;
+	for (std::int32_t n : key.normal)
+		h = (h ^ (h >> 29) ^ static_cast<std::uint32_t>(n)) * 0xbf58476d1ce4e5b9ull;
+	return static_cast<std::size_t>(h ^ (h >> 32));
+}
+
+SliceCache::SliceCache(std::size_t budgetBytes)
+	: m_budgetBytes{ budgetBytes }
+	, m_usedBytes{}
+	, m_distanceStep{ 1e-6f }
+	, m_hits{}
+	, m_misses{} {}
+
+bool SliceCache::MakeKey(mth::float3 plainNormal, float plainDistFromOrigin, Key& key) const
+{
+	// planes that do not fit the grid are never cached
+	const double distance = std::round(static_cast<double>(plainDistFromOrigin) / m_distanceStep);
+	if (!(std::abs(distance) < 9e18) || !(std::abs(plainNormal.x) <= 2.0f && std::abs(plainNormal.y) <= 2.0f && std::abs(plainNormal.z) <= 2.0f))
+		return false;
+	key.normal[0] = static_cast<std::int32_t>(std::round(plainNormal.x * s_normalSteps));
+	key.normal[1] = static_cast<std::int32_t>(std::round(plainNormal.y * s_normalSteps));
+	key.normal[2] = static_cast<std::int32_t>(std::round(plainNormal.z * s_normalSteps));
+	key.distance = static_cast<std::int64_t>(distance);
+	return true;
+}
+
+std::size_t SliceCache::EntryBytes(const Entry& entry)
+{
+	const ContourSet& contours = entry.contours;
+	return sizeof(Entry) + contours.points.capacity() * sizeof(mth::float2) + contours.contourOffsets.capacity() * sizeof(std::size_t) + contours.closed.capacity() / 8;
+}
+
+void SliceCache::Evict()
+{
+	while (m_usedBytes > m_budgetBytes && !m_entries.empty())
+	{
+		m_usedBytes -= EntryBytes(m_entries.back());
+		m_lookup.erase(m_entries.back().key);
+		m_entries.pop_back();
+	}
+}
+
+bool SliceCache::Find(mth::float3 plainNormal, float plainDistFromOrigin, ContourSet& contours)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Key key;
+	const auto found = MakeKey(plainNormal, plainDistFromOrigin, key) ? m_lookup.find(key) : m_lookup.end();
+	if (m_lookup.end() == found)
+	{
+		++m_misses;
+		return false;
+	}
+	++m_hits;
+	m_entries.splice(m_entries.begin(), m_entries, found->second);
+	contours = found->second->contours;
+	return true;
+}
+
+void SliceCache::Insert(mth::float3 plainNormal, float plainDistFromOrigin, const ContourSet& contours)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Key key;
+	if (!MakeKey(plainNormal, plainDistFromOrigin, key) || sizeof(Entry) + contours.points.size() * sizeof(mth::float2) > m_budgetBytes)
+		return;
+
+	const auto found = m_lookup.find(key);
+	if (m_lookup.end() != found)
+	{
+		m_usedBytes -= EntryBytes(*found->second);
+		m_entries.erase(found->second);
+		m_lookup.erase(found);
+	}
+	m_entries.push_front({ key, contours });
+	m_lookup.emplace(key, m_entries.begin());
+	m_usedBytes += EntryBytes(m_entries.front());
+	Evict();
+}
+
+void SliceCache::Reset(float distanceStep)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.clear();
+	m_lookup.clear();
+	m_usedBytes = 0;
+	m_distanceStep = std::isfinite(distanceStep) && distanceStep > 0.0f ? distanceStep : 1e-6f;
+}
+
+void SliceCache::SetBudget(std::size_t budgetBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_budgetBytes = budgetBytes;
+	Evict();
+}
+
+std::uint64_t SliceCache::Hits() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_hits;
+}
+
+std::uint64_t SliceCache::Misses() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_misses;
+}
+
+std::size_t SliceCache::UsedBytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_usedBytes;
+}
+
+std::size_t SliceCache::BudgetBytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_budgetBytes;
+}
+
+std::size_t SliceCache::SliceCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries.size();
+}
\ No newline at end of file
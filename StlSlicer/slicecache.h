@@ -0,0 +1,70 @@
+#pragma once
+
+#include "contour.h"
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Recently computed contours looked up by their plane.
+// Normals and distances are rounded to a grid first, so planes closer than one step share the contours.
+// Once the contours take more than the byte budget the least recently used ones are dropped.
+// Every member locks, so slicing threads can share one cache.
+class SliceCache
+{
+	struct Key
+	{
+		std::int32_t normal[3];
+		std::int64_t distance;
+
+		bool operator==(const Key&) const = default;
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& key) const;
+	};
+
+	struct Entry
+	{
+		Key key;
+		ContourSet contours;
+	};
+
+	mutable std::mutex m_mutex;
+	std::list<Entry> m_entries;	// most recently used first
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_lookup;
+	std::size_t m_budgetBytes;
+	std::size_t m_usedBytes;
+	float m_distanceStep;
+	std::uint64_t m_hits;
+	std::uint64_t m_misses;
+
+private:
+	bool MakeKey(mth::float3 plainNormal, float plainDistFromOrigin, Key& key) const;
+	static std::size_t EntryBytes(const Entry& entry);
+	void Evict();
+
+public:
+	static constexpr std::size_t DefaultBudgetBytes = 256 << 20;
+
+	SliceCache(std::size_t budgetBytes = DefaultBudgetBytes);
+
+	SliceCache(const SliceCache&) = delete;
+	SliceCache& operator=(const SliceCache&) = delete;
+
+	// copies the cached contours, false on a miss
+	bool Find(mth::float3 plainNormal, float plainDistFromOrigin, ContourSet& contours);
+	void Insert(mth::float3 plainNormal, float plainDistFromOrigin, const ContourSet& contours);
+	// drops every slice, for a new model with its own distance step
+	void Reset(float distanceStep);
+	void SetBudget(std::size_t budgetBytes);
+
+	std::uint64_t Hits() const;
+	std::uint64_t Misses() const;
+	std::size_t UsedBytes() const;
+	std::size_t BudgetBytes() const;
+	std::size_t SliceCount() const;
+};
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "sliceindex.h"
+#include "slicekernel.h"
+#include <algorithm>
+#include <cmath>
+
+// A triangle is cut by a plane when one corner is below it and another is on or above it,
+// matching how CalculateTriangleSlice treats corners lying on the plane.
+static inline bool Spans(float min, float max, float height)
+{
+	return min < height && height <= max;
+}
+
+std::uint32_t SliceIndex::AddNode(TriangleSpan* begin, TriangleSpan* end)
+{
+	// the median midpoint leaves at most half of the spans on either side
+	TriangleSpan* median = begin + (end - begin) / 2;
+	std::nth_element(begin, median, end, [](const TriangleSpan& a, const TriangleSpan& b) { return a.min + a.max < b.min + b.max; });
+	const float center = median->min * 0.5f + median->max * 0.5f;
+
+	TriangleSpan* crossingBegin = std::partition(begin, end, [center](const TriangleSpan& s) { return s.max < center; });
+	TriangleSpan* crossingEnd = std::partition(crossingBegin, end, [center](const TriangleSpan& s) { return s.min <= center; });
+
+	const std::uint32_t index = static_cast<std::uint32_t>(m_nodes.size());
+	m_nodes.push_back({ center, static_cast<std::uint32_t>(m_byMin.size()), static_cast<std::uint32_t>(crossingEnd - crossingBegin), 0, 0 });
+
+	const std::size_t first = m_byMin.size();
+	m_byMin.insert(m_byMin.end(), crossingBegin, crossingEnd);
+	m_byMax.insert(m_byMax.end(), crossingBegin, crossingEnd);
+	std::sort(m_byMin.begin() + first, m_byMin.end(), [](const TriangleSpan& a, const TriangleSpan& b) { return a.min < b.min; });
+	std::sort(m_byMax.begin() + first, m_byMax.end(), [](const TriangleSpan& a, const TriangleSpan& b) { return a.max > b.max; });
+
+	if (begin != crossingBegin)
+	{
+		const std::uint32_t below = AddNode(begin, crossingBegin);
+		m_nodes[index].below = below;
+	}
+	if (crossingEnd != end)
+	{
+		const std::uint32_t above = AddNode(crossingEnd, end);
+		m_nodes[index].above = above;
+	}
+	return index;
+}
+
+SliceIndex::SliceIndex(const IndexedMesh& mesh, mth::float3 plainNormal)
+	: SliceIndex(plainNormal, MeasureSpans(mesh, plainNormal)) {}
+
+SliceIndex::SliceIndex(mth::float3 plainNormal, std::vector<TriangleSpan> spans)
+	: m_plainNormal{ plainNormal }
+{
+	const auto bounded = std::partition(spans.begin(), spans.end(), [](const TriangleSpan& s) { return !std::isinf(s.min) && !std::isinf(s.max); });
+	m_unbounded.assign(bounded, spans.end());
+	spans.erase(bounded, spans.end());
+
+	m_byMin.reserve(spans.size());
+	m_byMax.reserve(spans.size());
+	if (!spans.empty())
+		AddNode(spans.data(), spans.data() + spans.size());
+}
+
+std::vector<SliceIndex::TriangleSpan> SliceIndex::MeasureSpans(const IndexedMesh& mesh, mth::float3 plainNormal)
+{
+	return MeasureSpans(mesh.positions, mesh.indices, mesh.Magnitude(), plainNormal);
+}
+
+std::vector<SliceIndex::TriangleSpan> SliceIndex::MeasureSpans(std::span<const mth::float3> positions, std::span<const std::uint32_t> indices, float magnitude, mth::float3 plainNormal)
+{
+	const mth::float3x3 plainTransform = PlainTransform(plainNormal);
+	std::vector<float> heights(positions.size());
+	for (std::size_t i = 0; i < heights.size(); ++i)
+		heights[i] = PlainHeight(plainTransform, positions[i]);
+	const float heightError = PlainHeightError(plainTransform, magnitude);
+
+	const std::size_t triangleCount = indices.size() / 3;
+	std::vector<TriangleSpan> spans;
+	spans.reserve(triangleCount);
+	for (std::size_t i = 0; i < triangleCount; ++i)
+	{
+		const float h0 = heights[indices[3 * i + 0]];
+		const float h1 = heights[indices[3 * i + 1]];
+		const float h2 = heights[indices[3 * i + 2]];
+		const TriangleSpan span{ std::min({ h0, h1, h2 }), std::max({ h0, h1, h2 }), static_cast<std::uint32_t>(i) };
+		if (std::isnan(h0) || std::isnan(h1) || std::isnan(h2) || (span.min == span.max && 0.0f == heightError))
+			continue;	// never cut by any plane
+		// the kernel may put a corner on the other side of a plane its rounded height misses by less than the error
+		spans.push_back({ span.min - heightError, span.max + heightError, span.triangle });
+	}
+	return spans;
+}
+
+void SliceIndex::Query(float plainDistFromOrigin, std::vector<std::uint32_t>& triangles) const
+{
+	for (const TriangleSpan& s : m_unbounded)
+		if (Spans(s.min, s.max, plainDistFromOrigin))
+			triangles.push_back(s.triangle);
+	if (m_nodes.empty())
+		return;
+
+	std::uint32_t index = 0;
+	do
+	{
+		const Node& node = m_nodes[index];
+		const TriangleSpan* first = m_byMin.data() + node.first;
+		const TriangleSpan* last = first + node.count;
+		if (plainDistFromOrigin < node.center)
+		{
+			// every span here reaches above the center, so only the lower end has to be checked
+			for (; first != last && first->min < plainDistFromOrigin; ++first)
+				triangles.push_back(first->triangle);
+			index = node.below;
+		}
+		else
+		{
+			first = m_byMax.data() + node.first;
+			last = first + node.count;
+			for (; first != last && first->max >= plainDistFromOrigin; ++first)
+				if (first->min < plainDistFromOrigin)
+					triangles.push_back(first->triangle);
+			index = node.above;
+		}
+	} while (0 != index);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "mesh.h"
+#include <vector>
+#include <span>
+#include <cstdint>
+
+// Interval tree over the height range every triangle covers along one slicing direction.
+// A query walks a single root to leaf path and only reads the triangles of each node that span the height,
+// so its cost follows the number of intersected triangles and the depth of the tree, not the mesh size.
+class SliceIndex
+{
+public:
+	struct TriangleSpan
+	{
+		float min;
+		float max;
+		std::uint32_t triangle;
+	};
+
+private:
+
+	struct Node
+	{
+		float center;
+		std::uint32_t first;	// triangles crossing the center, in both m_byMin and m_byMax
+		std::uint32_t count;
+		std::uint32_t below;	// child nodes, 0 if there is none as the root is nobody's child
+		std::uint32_t above;
+	};
+
+	mth::float3 m_plainNormal;
+	std::vector<Node> m_nodes;
+	std::vector<TriangleSpan> m_byMin;	// ascending min inside a node
+	std::vector<TriangleSpan> m_byMax;	// descending max inside a node
+	std::vector<TriangleSpan> m_unbounded;	// spans with infinite ends, checked by every query
+
+private:
+	std::uint32_t AddNode(TriangleSpan* begin, TriangleSpan* end);
+
+public:
+	SliceIndex(const IndexedMesh& mesh, mth::float3 plainNormal);
+	// builds from MeasureSpans without touching the mesh again, so it can run while the mesh is replaced
+	SliceIndex(mth::float3 plainNormal, std::vector<TriangleSpan> spans);
+
+	// the height ranges of the triangles some plane along the normal can cut
+	static std::vector<TriangleSpan> MeasureSpans(const IndexedMesh& mesh, mth::float3 plainNormal);
+	// the same over bare arrays, the magnitude bounds every coordinate like IndexedMesh::Magnitude
+	static std::vector<TriangleSpan> MeasureSpans(std::span<const mth::float3> positions, std::span<const std::uint32_t> indices, float magnitude, mth::float3 plainNormal);
+
+	// appends the triangles a slice at the given height can intersect, in no particular order
+	void Query(float plainDistFromOrigin, std::vector<std::uint32_t>& triangles) const;
+
+	inline mth::float3 PlainNormal() const { return m_plainNormal; }
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "sliceindexcache.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <exception>
+
+SliceIndexCache::SliceIndexCache()
+	: m_hasPrevPlainNormal{} {}
+
+std::shared_ptr<const SliceIndex> SliceIndexCache::Find(const IndexedMesh& mesh, mth::float3 plainNormal)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_build && m_build->done.load(std::memory_order_acquire))
+	{
+		if (m_build->index)
+		{
+			m_indices.insert(m_indices.begin(), std::move(m_build->index));
+			if (m_indices.size() > Capacity)
+				m_indices.pop_back();
+		}
+		m_build.reset();
+	}
+
+	const auto found = std::find_if(m_indices.begin(), m_indices.end(), [plainNormal](const std::shared_ptr<const SliceIndex>& index) { return index->PlainNormal() == plainNormal; });
+	if (m_indices.end() != found)
+	{
+		std::rotate(m_indices.begin(), found, found + 1);
+		return m_indices.front();
+	}
+
+	// building costs more than a full pass, so only a direction that is sliced again gets an index
+	const bool repeated = m_hasPrevPlainNormal && m_prevPlainNormal == plainNormal;
+	m_prevPlainNormal = plainNormal;
+	m_hasPrevPlainNormal = true;
+	if (!repeated || nullptr != m_build)
+		return nullptr;
+
+	std::shared_ptr<Build> build = std::make_shared<Build>();
+	build->plainNormal = plainNormal;
+	build->done = false;
+	m_build = build;
+	lock.unlock();	// the build is claimed, queueing it does not hold up other threads
+
+	try
+	{
+		// the task holds the owner of the arrays, so it reads them in place even if the mesh is replaced meanwhile
+		ThreadPool::Shared().Submit([build, owner = mesh.Owner(), positions = mesh.positions, indices = mesh.indices, magnitude = mesh.Magnitude()]() {
+			try
+			{
+				build->index = std::make_shared<const SliceIndex>(build->plainNormal, SliceIndex::MeasureSpans(positions, indices, magnitude, build->plainNormal));
+			}
+			catch (const std::exception&)
+			{
+				// slices of this direction keep taking the full pass
+			}
+			build->done.store(true, std::memory_order_release);
+			});
+	}
+	catch (...)
+	{
+		build->done.store(true, std::memory_order_release);	// lets a later Find start over
+		throw;
+	}
+	return nullptr;
+}
+
+void SliceIndexCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_indices.clear();
+	m_build.reset();
+	m_hasPrevPlainNormal = false;
+}
+
+bool SliceIndexCache::IsBuilding() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return nullptr != m_build;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "sliceindex.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+// Slice indices of the directions sliced lately, so a rotated plane can be moved as cheaply as an axis aligned one.
+// An index is built on the thread pool once a direction is sliced twice in a row, until it is ready that direction has none.
+// The build keeps the arrays of the mesh alive through IndexedMesh::Owner instead of copying them,
+// so the mesh may be replaced while it runs. Every member locks, so slicing threads can share one cache.
+class SliceIndexCache
+{
+	struct Build
+	{
+		mth::float3 plainNormal;
+		std::shared_ptr<const SliceIndex> index;	// stays empty if the build failed
+		std::atomic<bool> done;
+	};
+
+	mutable std::mutex m_mutex;
+	std::vector<std::shared_ptr<const SliceIndex>> m_indices;	// most recently used first
+	std::shared_ptr<Build> m_build;
+	mth::float3 m_prevPlainNormal;
+	bool m_hasPrevPlainNormal;
+
+public:
+	static constexpr std::size_t Capacity = 4;
+
+	SliceIndexCache();
+	SliceIndexCache(const SliceIndexCache&) = delete;
+	SliceIndexCache& operator=(const SliceIndexCache&) = delete;
+
+	// the index for the normal if one is ready, null otherwise
+	std::shared_ptr<const SliceIndex> Find(const IndexedMesh& mesh, mth::float3 plainNormal);
+	// drops every index, a build still running is left to finish and thrown away
+	void Clear();
+
+	bool IsBuilding() const;
+};
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "slicekernel.h"
+#include <atomic>
+#include <limits>
+#include <cmath>
+
+// A float dot product of three terms is off by at most 3u / (1 - 3u) of the sum of their magnitudes, rounded up to 4u = 2 epsilon.
+// The smallest normal float covers terms that underflow.
+static constexpr float s_heightErrorFactor = 2.0f * std::numeric_limits<float>::epsilon();
+// the same for the double sum of four exact products
+static constexpr double s_doubleErrorFactor = 3.0 * std::numeric_limits<double>::epsilon();
+
+static std::atomic<std::uint64_t> s_doubleFallbacks;
+static std::atomic<std::uint64_t> s_exactFallbacks;
+
+mth::float3x3 PlainTransform(mth::float3 plainNormal)
+{
+	// the rotation is undefined for the normal opposite the target, turn around the x axis instead
+	if (0.0f == 1.0f + plainNormal.y)
+		return mth::float3x3(
+			1.0f, 0.0f, 0.0f,
+			0.0f, -1.0f, 0.0f,
+			0.0f, 0.0f, -1.0f);
+	return mth::float3x3::RotateUnitVector(plainNormal, mth::float3(0.0f, 1.0f, 0.0f));
+}
+
+PlainAxis PlainAxisOf(const mth::float3x3& plainTransform)
+{
+	for (PlainAxis axis : { PlainAxis::PositiveX, PlainAxis::NegativeX, PlainAxis::PositiveY, PlainAxis::NegativeY, PlainAxis::PositiveZ, PlainAxis::NegativeZ })
+	{
+		bool match = true;
+		for (int row = 0; row < 3; ++row)
+			for (int column = 0; column < 3; ++column)
+				match = match && plainTransform(row, column) == (PlainAxisSource(axis, row) != column ? 0.0f : PlainAxisNegated(axis, row) ? -1.0f : 1.0f);
+		if (match)
+			return axis;
+	}
+	return PlainAxis::Rotated;
+}
+
+float PlainHeight(const mth::float3x3& plainTransform, mth::float3 position)
+{
+	return plainTransform(1, 0) * position.x + plainTransform(1, 1) * position.y + plainTransform(1, 2) * position.z;
+}
+
+bool PlainLayerRange(float minHeight, float maxHeight, float firstPlainDistance, float layerDistance, unsigned layerCount, unsigned& firstLayer, unsigned& lastLayer)
+{
+	const float first = std::floor((minHeight - firstPlainDistance) / layerDistance);
+	const float last = std::ceil((maxHeight - firstPlainDistance) / layerDistance);
+	const float lastLayerIndex = static_cast<float>(layerCount - 1);
+	if (!(last >= 0.0f && first <= lastLayerIndex))
+		return false;
+	firstLayer = first < 0.0f ? 0u : static_cast<unsigned>(first);
+	lastLayer = last > lastLayerIndex ? layerCount - 1 : static_cast<unsigned>(last);
+	return true;
+}
+
+mth::float3 PlainFramePoint(const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p)
+{
+	mth::float3 v = plainTransform * p;
+	v.y = PlainRelativeHeight(plainTransform, plainDistFromOrigin, p, v.y);
+	return v;
+}
+
+mth::float2 PlainEdgeCrossing(const mth::float3& from, const mth::float3& to)
+{
+	return mth::float2(from.x, from.z) + mth::float2(to.x - from.x, to.z - from.z) * std::abs(from.y / (to.y - from.y));
+}
+
+// an axis frame only copies the coordinate, so its heights are exact
+static inline bool ExactHeights(const mth::float3x3& plainTransform)
+{
+	const int zeros = (0.0f == plainTransform(1, 0)) + (0.0f == plainTransform(1, 1)) + (0.0f == plainTransform(1, 2));
+	return 2 == zeros && 1.0f == std::abs(plainTransform(1, 0) + plainTransform(1, 1) + plainTransform(1, 2));
+}
+
+float PlainHeightError(const mth::float3x3& plainTransform, float magnitude)
+{
+	if (ExactHeights(plainTransform))
+		return 0.0f;
+	const float rowMagnitude = std::abs(plainTransform(1, 0)) + std::abs(plainTransform(1, 1)) + std::abs(plainTransform(1, 2));
+	const float error = s_heightErrorFactor * rowMagnitude * magnitude + std::numeric_limits<float>::min();
+	return std::isnan(error) ? std::numeric_limits<float>::infinity() : error;	// unknown bounds trust no height
+}
+
+float PlainHeightError(const mth::float3x3& plainTransform, const mth::float3& p)
+{
+	if (ExactHeights(plainTransform))
+		return 0.0f;
+	const float termMagnitude = std::abs(plainTransform(1, 0) * p.x) + std::abs(plainTransform(1, 1) * p.y) + std::abs(plainTransform(1, 2) * p.z);
+	return s_heightErrorFactor * termMagnitude + std::numeric_limits<float>::min();
+}
+
+static inline void TwoSum(double a, double b, double& sum, double& error)
+{
+	sum = a + b;
+	const double bVirtual = sum - a;
+	error = (a - (sum - bVirtual)) + (b - bVirtual);
+}
+
+// The sign of the plain height of p minus the distance. Float products are exact in double, so only the sum can round,
+// when even the double sum is too close to zero it is summed exactly into a non-overlapping expansion.
+static int PlainSide(const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p)
+{
+	s_doubleFallbacks.fetch_add(1, std::memory_order_relaxed);
+	const double terms[] = {
+		static_cast<double>(plainTransform(1, 0)) * p.x,
+		static_cast<double>(plainTransform(1, 1)) * p.y,
+		static_cast<double>(plainTransform(1, 2)) * p.z,
+		-static_cast<double>(plainDistFromOrigin) };
+	const double sum = ((terms[0] + terms[1]) + terms[2]) + terms[3];
+	const double magnitude = std::abs(terms[0]) + std::abs(terms[1]) + std::abs(terms[2]) + std::abs(terms[3]);
+	if (std::abs(sum) > s_doubleErrorFactor * magnitude)
+		return sum > 0.0 ? 1 : -1;
+
+	s_exactFallbacks.fetch_add(1, std::memory_order_relaxed);
+	double expansion[4];
+	int length = 0;
+	for (double term : terms)
+	{
+		// grow the expansion by one term, dropping zero components, the largest stays last
+		double carry = term;
+		int grown = 0;
+		for (int i = 0; i < length; ++i)
+		{
+			double error;
+			TwoSum(carry, expansion[i], carry, error);
+			if (0.0 != error)
+				expansion[grown++] = error;
+		}
+		expansion[grown++] = carry;
+		length = grown;
+	}
+	for (int i = length - 1; i >= 0; --i)
+		if (0.0 != expansion[i])
+			return expansion[i] > 0.0 ? 1 : -1;
+	return 0;
+}
+
+float PlainRelativeHeight(const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p, float frameHeight)
+{
+	// the subtraction keeps the sign of the difference, only the rounding of frameHeight can put the corner on the wrong side
+	const float y = frameHeight - plainDistFromOrigin;
+	const float error = PlainHeightError(plainTransform, p);
+	if (!(std::abs(y) <= error))
+		return y;
+	if (0.0f == error)
+		return 0.0f == y ? std::numeric_limits<float>::min() : y;
+	if (PlainSide(plainTransform, plainDistFromOrigin, p) < 0)
+		return y < 0.0f ? y : -std::numeric_limits<float>::min();
+	return y > 0.0f ? y : std::numeric_limits<float>::min();
+}
+
+PlainPredicateCounts GetPlainPredicateCounts()
+{
+	return { s_doubleFallbacks.load(std::memory_order_relaxed), s_exactFallbacks.load(std::memory_order_relaxed) };
+}
+
+void ResetPlainPredicateCounts()
+{
+	s_doubleFallbacks.store(0, std::memory_order_relaxed);
+	s_exactFallbacks.store(0, std::memory_order_relaxed);
+}
+
+// the corners are in the plain frame with their heights taken from PlainRelativeHeight
+template <typename Emit>
+static inline void SliceFrameTriangle(const mth::float3& v0, const mth::float3& v1, const mth::float3& v2, Emit&& emit)
+{
+	const mth::float3 v[] = { v0, v1, v2 };
+	if (v[0].y * v[1].y < 0.0f)
+		emit(0, PlainEdgeCrossing(v[0], v[1]));
+	if (v[1].y * v[2].y < 0.0f)
+		emit(1, PlainEdgeCrossing(v[1], v[2]));
+	if (v[2].y * v[0].y < 0.0f)
+		emit(2, PlainEdgeCrossing(v[2], v[0]));
+}
+
+template <typename Emit>
+static inline void SliceTriangle(const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p0, const mth::float3& p1, const mth::float3& p2, Emit&& emit)
+{
+	SliceFrameTriangle(PlainFramePoint(plainTransform, plainDistFromOrigin, p0), PlainFramePoint(plainTransform, plainDistFromOrigin, p1), PlainFramePoint(plainTransform, plainDistFromOrigin, p2), emit);
+}
+
+int CalculateTriangleSlice(mth::float2* output, const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p0, const mth::float3& p1, const mth::float3& p2)
+{
+	int count = 0;
+	SliceTriangle(plainTransform, plainDistFromOrigin, p0, p1, p2, [output, &count](int, mth::float2 p) { output[count++] = p; });
+	return count;
+}
+
+int CalculateFrameTriangleSlice(mth::float2* output, const mth::float3& v0, const mth::float3& v1, const mth::float3& v2)
+{
+	int count = 0;
+	SliceFrameTriangle(v0, v1, v2, [output, &count](int, mth::float2 p) { output[count++] = p; });
+	return count;
+}
+
+void CalculateTriangleSlice(std::vector<mth::float2>& outputContainer, const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p0, const mth::float3& p1, const mth::float3& p2)
+{
+	SliceTriangle(plainTransform, plainDistFromOrigin, p0, p1, p2, [&outputContainer](int, mth::float2 p) { outputContainer.push_back(p); });
+}
+
+bool CalculateTriangleSegment(mth::float2 points[2], int edges[2], const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p0, const mth::float3& p1, const mth::float3& p2)
+{
+	int count = 0;
+	SliceTriangle(plainTransform, plainDistFromOrigin, p0, p1, p2, [&](int edge, mth::float2 p) {
+		if (count < 2)
+		{
+			points[count] = p;
+			edges[count] = edge;
+		}
+		++count;
+		});
+	return 2 == count;	// a NaN corner can leave a single crossing
+}
\ No newline at end of file
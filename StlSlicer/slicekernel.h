@@ -0,0 +1,86 @@
+#pragma once
+
+#include "math/position.hpp"
+#include <vector>
+#include <cstdint>
+
+// Plain frame: x and z lie in the plain, y is the height along the normal.
+mth::float3x3 PlainTransform(mth::float3 plainNormal);
+float PlainHeight(const mth::float3x3& plainTransform, mth::float3 position);
+// Layers [firstLayer, lastLayer] of an evenly spaced stack a triangle spanning the given heights can intersect,
+// rounded outwards so the kernel makes the final decision. False if it misses every layer.
+bool PlainLayerRange(float minHeight, float maxHeight, float firstPlainDistance, float layerDistance, unsigned layerCount, unsigned& firstLayer, unsigned& lastLayer);
+// Normals along a coordinate axis, where the plain frame only swaps and negates coordinates.
+enum class PlainAxis
+{
+	Rotated,	// any other normal
+	PositiveX,
+	NegativeX,
+	PositiveY,
+	NegativeY,
+	PositiveZ,
+	NegativeZ
+};
+
+// The model coordinate frame axis i of the plain frame is read from, and whether it is negated.
+constexpr int PlainAxisSource(PlainAxis axis, int frameAxis)
+{
+	switch (axis)
+	{
+	case PlainAxis::PositiveX:
+	case PlainAxis::NegativeX:
+		return 1 == frameAxis ? 0 : 0 == frameAxis ? 1 : 2;
+	case PlainAxis::PositiveZ:
+	case PlainAxis::NegativeZ:
+		return 1 == frameAxis ? 2 : 2 == frameAxis ? 1 : 0;
+	default:
+		return frameAxis;
+	}
+}
+constexpr bool PlainAxisNegated(PlainAxis axis, int frameAxis)
+{
+	switch (axis)
+	{
+	case PlainAxis::PositiveX: return 0 == frameAxis;
+	case PlainAxis::NegativeX: return 1 == frameAxis;
+	case PlainAxis::NegativeY: return 0 != frameAxis;
+	case PlainAxis::PositiveZ: return 2 == frameAxis;
+	case PlainAxis::NegativeZ: return 1 == frameAxis;
+	default: return false;
+	}
+}
+// which axis PlainTransform returned the matrix for, Rotated unless it is exactly an axis frame
+PlainAxis PlainAxisOf(const mth::float3x3& plainTransform);
+
+// Bounds on how far PlainHeight can be off, for one position or any position with coordinates within magnitude of the origin.
+// Zero for axis frames, whose heights are exact. Candidate tests widen the height span of a triangle by it,
+// so they keep every triangle the kernels may cut.
+float PlainHeightError(const mth::float3x3& plainTransform, float magnitude);
+float PlainHeightError(const mth::float3x3& plainTransform, const mth::float3& p);
+// The height of p above the plain, frameHeight being its float PlainHeight. Never zero, corners on the plain count as above it.
+// The float difference is trusted when it is further from zero than PlainHeightError, closer ones get their side from
+// a double evaluation and, if that is still too close, an exact one, and are moved to the smallest float on that side.
+float PlainRelativeHeight(const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p, float frameHeight);
+// A corner in the plain frame with its height from PlainRelativeHeight, the way every kernel sees it.
+mth::float3 PlainFramePoint(const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p);
+
+// How many corner side tests since the last reset the float test could not decide, and how many of those double could not either.
+struct PlainPredicateCounts
+{
+	std::uint64_t doubleFallbacks;
+	std::uint64_t exactFallbacks;
+};
+PlainPredicateCounts GetPlainPredicateCounts();
+void ResetPlainPredicateCounts();
+
+// Where the plain cuts the edge between two plain frame points of opposite sign.
+// Only bitwise repeatable when the ends of an edge are always passed in the same order.
+mth::float2 PlainEdgeCrossing(const mth::float3& from, const mth::float3& to);
+
+// writes at most three points, returns how many
+int CalculateTriangleSlice(mth::float2* output, const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p0, const mth::float3& p1, const mth::float3& p2);
+// Same as CalculateTriangleSlice with the corners already in the plain frame and their heights from PlainRelativeHeight.
+int CalculateFrameTriangleSlice(mth::float2* output, const mth::float3& v0, const mth::float3& v1, const mth::float3& v2);
+void CalculateTriangleSlice(std::vector<mth::float2>& outputContainer, const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p0, const mth::float3& p1, const mth::float3& p2);
+// Cuts one triangle like CalculateTriangleSlice and also names the edges the two points lie on (0: p0-p1, 1: p1-p2, 2: p2-p0).
+bool CalculateTriangleSegment(mth::float2 points[2], int edges[2], const mth::float3x3& plainTransform, float plainDistFromOrigin, const mth::float3& p0, const mth::float3& p1, const mth::float3& p2);
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "slicesession.h"
+#include "slicekernel.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+static constexpr std::size_t s_itemsPerTask = 1 << 16;
+static constexpr std::size_t s_trianglesPerBucket = 16;
+
+static inline std::size_t TaskCount(std::size_t itemCount)
+{
+	return (itemCount + s_itemsPerTask - 1) / s_itemsPerTask;
+}
+
+SliceSession::SliceSession(const IndexedMesh& mesh, SliceIndexCache& indices)
+	: m_mesh{ mesh }
+	, m_indices{ indices }
+	, m_plainDistance{}
+	, m_hasPlain{}
+	, m_hasHeights{}
+	, m_hasActive{}
+	, m_bucketBase{}
+	, m_bucketScale{} {}
+
+std::size_t SliceSession::Bucket(float height) const
+{
+	// monotonic in the height, infinities go to the end buckets and NaN to the first
+	const std::size_t bucketCount = m_minOffsets.size() - 1;
+	const float bucket = (height - m_bucketBase) * m_bucketScale;
+	if (!(bucket > 0.0f))
+		return 0;
+	if (bucket >= static_cast<float>(bucketCount - 1))
+		return bucketCount - 1;
+	return static_cast<std::size_t>(bucket);
+}
+
+void SliceSession::MeasureHeights()
+{
+	m_heights.resize(m_mesh.positions.size());
+	ThreadPool::Shared().ParallelFor(TaskCount(m_heights.size()), [this](std::size_t task) {
+		const std::size_t last = std::min(m_heights.size(), (task + 1) * s_itemsPerTask);
+		for (std::size_t i = task * s_itemsPerTask; i < last; ++i)
+			m_heights[i] = PlainHeight(m_plainTransform, m_mesh.positions[i]);
+		});
+
+	const std::size_t triangleCount = m_mesh.TriangleCount();
+	m_minHeights.resize(triangleCount);
+	m_maxHeights.resize(triangleCount);
+	// widened by the rounding error of the heights, the kernel decides the side of corners that close to a plain itself
+	const float heightError = PlainHeightError(m_plainTransform, m_mesh.Magnitude());
+	ThreadPool::Shared().ParallelFor(TaskCount(triangleCount), [this, triangleCount, heightError](std::size_t task) {
+		const std::size_t last = std::min(triangleCount, (task + 1) * s_itemsPerTask);
+		for (std::size_t i = task * s_itemsPerTask; i < last; ++i)
+		{
+			const float h0 = m_heights[m_mesh.indices[3 * i + 0]];
+			const float h1 = m_heights[m_mesh.indices[3 * i + 1]];
+			const float h2 = m_heights[m_mesh.indices[3 * i + 2]];
+			// a NaN corner leaves no edge pair to cut, such triangles are never active
+			if (std::isnan(h0) || std::isnan(h1) || std::isnan(h2))
+			{
+				m_minHeights[i] = std::numeric_limits<float>::quiet_NaN();
+				m_maxHeights[i] = std::numeric_limits<float>::quiet_NaN();
+			}
+			else
+			{
+				m_minHeights[i] = std::min({ h0, h1, h2 }) - heightError;
+				m_maxHeights[i] = std::max({ h0, h1, h2 }) + heightError;
+			}
+		}
+		});
+	m_hasHeights = true;
+
+	m_minOffsets.clear();
+	m_byMin.clear();
+	m_maxOffsets.clear();
+	m_byMax.clear();
+}
+
+void SliceSession::Rescan(float plainDistFromOrigin)
+{
+	const std::size_t triangleCount = m_mesh.TriangleCount();
+	std::vector<std::vector<std::uint32_t>> taskActive(TaskCount(triangleCount));
+	ThreadPool::Shared().ParallelFor(taskActive.size(), [&](std::size_t task) {
+		const std::size_t last = std::min(triangleCount, (task + 1) * s_itemsPerTask);
+		for (std::size_t i = task * s_itemsPerTask; i < last; ++i)
+			if (IsActive(static_cast<std::uint32_t>(i), plainDistFromOrigin))
+				taskActive[task].push_back(static_cast<std::uint32_t>(i));
+		});
+
+	m_active.clear();
+	for (const std::vector<std::uint32_t>& active : taskActive)
+		m_active.insert(m_active.end(), active.begin(), active.end());
+}
+
+void SliceSession::BuildBuckets()
+{
+	float low = std::numeric_limits<float>::infinity();
+	float high = -std::numeric_limits<float>::infinity();
+	for (float h : m_heights)
+	{
+		if (std::isfinite(h))
+		{
+			low = std::min(low, h);
+			high = std::max(high, h);
+		}
+	}
+
+	const std::size_t triangleCount = m_mesh.TriangleCount();
+	const std::size_t bucketCount = std::max<std::size_t>(1, triangleCount / s_trianglesPerBucket);
+	m_bucketBase = low < high ? low : 0.0f;
+	m_bucketScale = low < high ? static_cast<float>(bucketCount) / (high - low) : 0.0f;
+	if (!std::isfinite(m_bucketScale))
+		m_bucketScale = 0.0f;
+
+	m_minOffsets.assign(bucketCount + 1, 0);
+	m_maxOffsets.assign(bucketCount + 1, 0);
+	for (std::size_t i = 0; i < triangleCount; ++i)
+	{
+		if (std::isnan(m_minHeights[i]))
+			continue;
+		++m_minOffsets[Bucket(m_minHeights[i]) + 1];
+		++m_maxOffsets[Bucket(m_maxHeights[i]) + 1];
+	}
+	for (std::size_t b = 0; b < bucketCount; ++b)
+	{
+		m_minOffsets[b + 1] += m_minOffsets[b];
+		m_maxOffsets[b + 1] += m_maxOffsets[b];
+	}
+
+	m_byMin.resize(m_minOffsets[bucketCount]);
+	m_byMax.resize(m_maxOffsets[bucketCount]);
+	std::vector<std::size_t> minCursors(m_minOffsets.begin(), m_minOffsets.end() - 1);
+	std::vector<std::size_t> maxCursors(m_maxOffsets.begin(), m_maxOffsets.end() - 1);
+	for (std::size_t i = 0; i < triangleCount; ++i)
+	{
+		if (std::isnan(m_minHeights[i]))
+			continue;
+		m_byMin[minCursors[Bucket(m_minHeights[i])]++] = static_cast<std::uint32_t>(i);
+		m_byMax[maxCursors[Bucket(m_maxHeights[i])]++] = static_cast<std::uint32_t>(i);
+	}
+}
+
+void SliceSession::Move(float plainDistFromOrigin)
+{
+	if (m_minOffsets.empty())
+		BuildBuckets();
+
+	const float from = m_plainDistance;
+	const float to = plainDistFromOrigin;
+	m_active.erase(std::remove_if(m_active.begin(), m_active.end(), [this, to](std::uint32_t i) { return !IsActive(i, to); }), m_active.end());
+
+	// going up a triangle is entered when the plane passes its lowest corner, going down when it passes the highest one
+	const bool up = from < to;
+	const std::vector<std::size_t>& offsets = up ? m_minOffsets : m_maxOffsets;
+	const std::vector<std::uint32_t>& triangles = up ? m_byMin : m_byMax;
+	const std::size_t first = offsets[Bucket(std::min(from, to))];
+	const std::size_t last = offsets[Bucket(std::max(from, to)) + 1];
+	for (std::size_t i = first; i < last; ++i)
+		if (IsActive(triangles[i], to) && !IsActive(triangles[i], from))
+			m_active.push_back(triangles[i]);
+}
+
+ContourSet SliceSession::CalcContours(mth::float3 plainNormal, float plainDistFromOrigin)
+{
+	if (!m_hasPlain || m_plainNormal != plainNormal)
+	{
+		m_plainNormal = plainNormal;
+		m_plainTransform = PlainTransform(plainNormal);
+		m_hasPlain = true;
+		m_hasHeights = false;
+		m_hasActive = false;
+	}
+	const bool moved = !m_hasActive || m_plainDistance != plainDistFromOrigin;
+	if (const std::shared_ptr<const SliceIndex> index = m_indices.Find(m_mesh, plainNormal))
+	{
+		// the index holds the same height ranges, so a later move without it can go on from its triangles
+		if (moved)
+		{
+			m_active.clear();
+			index->Query(plainDistFromOrigin, m_active);
+		}
+	}
+	else
+	{
+		if (!m_hasHeights)
+			MeasureHeights();
+		if (!m_hasActive || std::isnan(m_plainDistance) || std::isnan(plainDistFromOrigin))
+			Rescan(plainDistFromOrigin);
+		else if (moved)
+			Move(plainDistFromOrigin);
+	}
+	m_plainDistance = plainDistFromOrigin;
+	m_hasActive = true;
+
+	std::vector<std::vector<EdgeSegment>> taskSegments(TaskCount(m_active.size()));
+	ThreadPool::Shared().ParallelFor(taskSegments.size(), [&](std::size_t task) {
+		const std::size_t last = std::min(m_active.size(), (task + 1) * s_itemsPerTask);
+		EdgeSegment segment;
+		for (std::size_t i = task * s_itemsPerTask; i < last; ++i)
+			if (CalculateEdgeSegment(segment, m_mesh, m_active[i], m_plainTransform, plainDistFromOrigin))
+				taskSegments[task].push_back(segment);
+		});
+
+	std::vector<EdgeSegment> segments;
+	for (const std::vector<EdgeSegment>& part : taskSegments)
+		segments.insert(segments.end(), part.begin(), part.end());
+	return JoinSegments(segments);
+}
\ No newline at end of file
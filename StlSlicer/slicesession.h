@@ -0,0 +1,56 @@
+#pragma once
+
+#include "mesh.h"
+#include "contour.h"
+#include "sliceindexcache.h"
+#include <vector>
+#include <cstdint>
+
+// Slices one mesh over and over while the plane is dragged.
+// The crossed triangles come from the slice index of the normal once the shared cache has it ready,
+// so moving a rotated plane only reads the triangles it cuts.
+// Until then the vertex heights along the normal are kept while the normal stays the same, and so is the set of triangles the plane crosses.
+// Moving the plane along the normal only tests the triangles whose height range starts or ends between the old and the new distance,
+// found through the triangles bucketed by their lowest and highest corner.
+class SliceSession
+{
+	const IndexedMesh& m_mesh;
+	SliceIndexCache& m_indices;
+	mth::float3 m_plainNormal;
+	mth::float3x3 m_plainTransform;
+	float m_plainDistance;
+	bool m_hasPlain;
+	bool m_hasHeights;	// the height ranges belong to m_plainNormal
+	bool m_hasActive;	// m_active belongs to m_plainNormal and m_plainDistance
+
+	std::vector<float> m_heights;	// per vertex
+	std::vector<float> m_minHeights;	// per triangle
+	std::vector<float> m_maxHeights;
+	std::vector<std::uint32_t> m_active;	// triangles with min < distance <= max, in no particular order
+
+	// built on the first move along a normal, bucket b owns [offsets[b], offsets[b + 1]) of the arrays
+	float m_bucketBase;
+	float m_bucketScale;
+	std::vector<std::size_t> m_minOffsets;
+	std::vector<std::uint32_t> m_byMin;
+	std::vector<std::size_t> m_maxOffsets;
+	std::vector<std::uint32_t> m_byMax;
+
+private:
+	inline bool IsActive(std::uint32_t triangle, float plainDistFromOrigin) const { return m_minHeights[triangle] < plainDistFromOrigin && plainDistFromOrigin <= m_maxHeights[triangle]; }
+	std::size_t Bucket(float height) const;
+	void MeasureHeights();
+	void Rescan(float plainDistFromOrigin);
+	void BuildBuckets();
+	void Move(float plainDistFromOrigin);
+
+public:
+	SliceSession(const IndexedMesh& mesh, SliceIndexCache& indices);
+	SliceSession(const SliceSession&) = delete;
+	SliceSession& operator=(const SliceSession&) = delete;
+
+	// The same contours as Model::CalcContours, a closed contour may start at another point.
+	ContourSet CalcContours(mth::float3 plainNormal, float plainDistFromOrigin);
+
+	inline std::size_t ActiveTriangleCount() const { return m_active.size(); }
+};
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include "slicesimd.h"
+#include "slicekernel.h"
+#include <intrin.h>
+#include <immintrin.h>
+#include <bit>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+
+static constexpr std::size_t s_padding = 8;
+static constexpr std::size_t s_outputSlack = 16;	// points a kernel may write past its last one
+
+// a kernel writes nothing at or past outputEnd
+using SliceKernel = std::size_t(*)(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output, const mth::float2* outputEnd);
+using CountKernel = std::size_t(*)(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count);
+
+TriangleSoA::TriangleSoA(const IndexedMesh& mesh)
+	: m_count{ mesh.TriangleCount() }
+	, m_stride{ mesh.TriangleCount() + s_padding }
+	, m_magnitude{ mesh.Magnitude() }
+{
+	// the zero padding is never cut, as all corners of a padding triangle are at the same height
+	m_coords.resize(9 * m_stride);
+	for (std::size_t i = 0; i < m_count; ++i)
+	{
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			const mth::float3& p = mesh.Position(i, corner);
+			m_coords[(3 * corner + 0) * m_stride + i] = p.x;
+			m_coords[(3 * corner + 1) * m_stride + i] = p.y;
+			m_coords[(3 * corner + 2) * m_stride + i] = p.z;
+		}
+	}
+}
+
+// Every kernel is instantiated for the rotated frame and for each axis frame.
+// An axis frame reads the coordinates straight from their arrays instead of multiplying by the plain transform,
+// the points are the same as with the multiplication except for the sign of zeros and for non-finite coordinates.
+
+template <PlainAxis Axis, int FrameAxis>
+static inline float FrameCoord(const TriangleSoA& triangles, int corner, std::size_t i)
+{
+	const float c = triangles.Coords(corner, PlainAxisSource(Axis, FrameAxis))[i];
+	return PlainAxisNegated(Axis, FrameAxis) ? -c : c;
+}
+
+// the corner in the plain frame with its height relative to the plain, as PlainFramePoint gives it
+template <PlainAxis Axis>
+static inline mth::float3 FrameCorner(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, int corner, std::size_t i)
+{
+	if constexpr (PlainAxis::Rotated == Axis)
+		return PlainFramePoint(plainTransform, plainDistFromOrigin, mth::float3(triangles.Coords(corner, 0)[i], triangles.Coords(corner, 1)[i], triangles.Coords(corner, 2)[i]));
+	else
+	{
+		mth::float3 v(FrameCoord<Axis, 0>(triangles, corner, i), FrameCoord<Axis, 1>(triangles, corner, i) - plainDistFromOrigin, FrameCoord<Axis, 2>(triangles, corner, i));
+		if (0.0f == v.y)
+			v.y = std::numeric_limits<float>::min();
+		return v;
+	}
+}
+
+template <PlainAxis Axis>
+static inline float FrameHeight(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, int corner, std::size_t i)
+{
+	if constexpr (PlainAxis::Rotated == Axis)
+	{
+		const mth::float3 p(triangles.Coords(corner, 0)[i], triangles.Coords(corner, 1)[i], triangles.Coords(corner, 2)[i]);
+		return PlainRelativeHeight(plainTransform, plainDistFromOrigin, p, PlainHeight(plainTransform, p));
+	}
+	else
+	{
+		const float y = FrameCoord<Axis, 1>(triangles, corner, i) - plainDistFromOrigin;
+		return 0.0f == y ? std::numeric_limits<float>::min() : y;
+	}
+}
+
+template <PlainAxis Axis>
+static inline std::size_t SliceScalarRange(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output)
+{
+	mth::float2* cursor = output;
+	for (std::size_t i = first; i < first + count; ++i)
+	{
+		mth::float3 v[3];
+		for (int corner = 0; corner < 3; ++corner)
+			v[corner] = FrameCorner<Axis>(triangles, plainTransform, plainDistFromOrigin, corner, i);
+		cursor += CalculateFrameTriangleSlice(cursor, v[0], v[1], v[2]);
+	}
+	return static_cast<std::size_t>(cursor - output);
+}
+
+template <PlainAxis Axis>
+static std::size_t CountScalar(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count)
+{
+	std::size_t points = 0;
+	for (std::size_t i = first; i < first + count; ++i)
+	{
+		float y[3];
+		for (int corner = 0; corner < 3; ++corner)
+			y[corner] = FrameHeight<Axis>(triangles, plainTransform, plainDistFromOrigin, corner, i);
+		points += (y[0] * y[1] < 0.0f) + (y[1] * y[2] < 0.0f) + (y[2] * y[0] < 0.0f);
+	}
+	return points;
+}
+
+// Every kernel computes the same expressions in the same order as the scalar one, so the results are bitwise equal.
+// Per triangle the first point is on edge 0 if it is crossed, otherwise on edge 1, the second is on edge 2 unless edges 0 and 1 are the crossed ones.
+// A NaN corner can make a single edge crossed, such groups go through the scalar kernel to keep its output.
+// So do the groups of the rotated frame with a corner closer to the plain than the rounding error of its height,
+// the scalar kernel decides their side more precisely. Axis frame heights are exact.
+
+template <PlainAxis Axis, int FrameAxis>
+static inline __m128 FrameCoordSse41(const TriangleSoA& triangles, int corner, std::size_t i)
+{
+	const __m128 c = _mm_loadu_ps(triangles.Coords(corner, PlainAxisSource(Axis, FrameAxis)) + i);
+	return PlainAxisNegated(Axis, FrameAxis) ? _mm_xor_ps(c, _mm_set1_ps(-0.0f)) : c;
+}
+
+template <PlainAxis Axis>
+static std::size_t SliceSse41(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output, const mth::float2*)
+{
+	__m128 m[3][3];
+	for (int r = 0; r < 3; ++r)
+		for (int c = 0; c < 3; ++c)
+			m[r][c] = _mm_set1_ps(plainTransform(r, c));
+	const __m128 distance = _mm_set1_ps(plainDistFromOrigin);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 smallest = _mm_set1_ps(std::numeric_limits<float>::min());
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 heightError = _mm_set1_ps(PlainHeightError(plainTransform, triangles.Magnitude()));
+
+	float* cursor = reinterpret_cast<float*>(output);
+	const std::size_t end = first + count;
+	for (std::size_t i = first; i < end; i += 4)
+	{
+		const int laneBits = end - i >= 4 ? 0xf : (1 << (end - i)) - 1;
+		__m128 x[3], y[3], z[3];
+		__m128 nearPlain = zero;
+		for (int k = 0; k < 3; ++k)
+		{
+			if constexpr (PlainAxis::Rotated == Axis)
+			{
+				const __m128 px = _mm_loadu_ps(triangles.Coords(k, 0) + i);
+				const __m128 py = _mm_loadu_ps(triangles.Coords(k, 1) + i);
+				const __m128 pz = _mm_loadu_ps(triangles.Coords(k, 2) + i);
+				x[k] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], px), _mm_mul_ps(m[0][1], py)), _mm_mul_ps(m[0][2], pz));
+				y[k] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1][0], px), _mm_mul_ps(m[1][1], py)), _mm_mul_ps(m[1][2], pz)), distance);
+				nearPlain = _mm_or_ps(nearPlain, _mm_cmple_ps(_mm_and_ps(y[k], absMask), heightError));
+				z[k] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2][0], px), _mm_mul_ps(m[2][1], py)), _mm_mul_ps(m[2][2], pz));
+			}
+			else
+			{
+				x[k] = FrameCoordSse41<Axis, 0>(triangles, k, i);
+				y[k] = _mm_sub_ps(FrameCoordSse41<Axis, 1>(triangles, k, i), distance);
+				z[k] = FrameCoordSse41<Axis, 2>(triangles, k, i);
+			}
+			y[k] = _mm_blendv_ps(y[k], smallest, _mm_cmpeq_ps(y[k], zero));
+		}
+
+		const __m128 cross01 = _mm_cmplt_ps(_mm_mul_ps(y[0], y[1]), zero);
+		const __m128 cross12 = _mm_cmplt_ps(_mm_mul_ps(y[1], y[2]), zero);
+		const __m128 cross20 = _mm_cmplt_ps(_mm_mul_ps(y[2], y[0]), zero);
+		const int bits01 = _mm_movemask_ps(cross01) & laneBits;
+		const int bits12 = _mm_movemask_ps(cross12) & laneBits;
+		const int bits20 = _mm_movemask_ps(cross20) & laneBits;
+		const int crossed = bits01 | bits12 | bits20;
+		if (0 != (_mm_movemask_ps(nearPlain) & laneBits) || 0 != (bits01 ^ bits12 ^ bits20))
+		{
+			cursor += 2 * SliceScalarRange<Axis>(triangles, plainTransform, plainDistFromOrigin, i, std::min<std::size_t>(4, end - i), reinterpret_cast<mth::float2*>(cursor));
+			continue;
+		}
+		if (0 == crossed)
+			continue;
+
+		__m128 ex[3], ez[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			const int l = (k + 1) % 3;
+			const __m128 t = _mm_and_ps(_mm_div_ps(y[k], _mm_sub_ps(y[l], y[k])), absMask);
+			ex[k] = _mm_add_ps(x[k], _mm_mul_ps(_mm_sub_ps(x[l], x[k]), t));
+			ez[k] = _mm_add_ps(z[k], _mm_mul_ps(_mm_sub_ps(z[l], z[k]), t));
+		}
+		const __m128 secondOnEdge1 = _mm_and_ps(cross01, cross12);
+		__m128 firstX = _mm_blendv_ps(ex[1], ex[0], cross01);
+		__m128 firstZ = _mm_blendv_ps(ez[1], ez[0], cross01);
+		__m128 secondX = _mm_blendv_ps(ex[2], ex[1], secondOnEdge1);
+		__m128 secondZ = _mm_blendv_ps(ez[2], ez[1], secondOnEdge1);
+
+		// after the transpose every register holds the two points of one triangle
+		_MM_TRANSPOSE4_PS(firstX, firstZ, secondX, secondZ);
+		const __m128 lanes[4] = { firstX, firstZ, secondX, secondZ };
+		for (int bits = crossed; 0 != bits; bits &= bits - 1)
+		{
+			_mm_storeu_ps(cursor, lanes[std::countr_zero(static_cast<unsigned>(bits))]);	// exactly the two points, never past the output
+			cursor += 4;
+		}
+	}
+	return static_cast<std::size_t>(reinterpret_cast<mth::float2*>(cursor) - output);
+}
+
+template <PlainAxis Axis>
+static std::size_t CountSse41(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count)
+{
+	const __m128 m0 = _mm_set1_ps(plainTransform(1, 0));
+	const __m128 m1 = _mm_set1_ps(plainTransform(1, 1));
+	const __m128 m2 = _mm_set1_ps(plainTransform(1, 2));
+	const __m128 distance = _mm_set1_ps(plainDistFromOrigin);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 smallest = _mm_set1_ps(std::numeric_limits<float>::min());
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 heightError = _mm_set1_ps(PlainHeightError(plainTransform, triangles.Magnitude()));
+
+	std::size_t points = 0;
+	const std::size_t end = first + count;
+	for (std::size_t i = first; i < end; i += 4)
+	{
+		const int laneBits = end - i >= 4 ? 0xf : (1 << (end - i)) - 1;
+		__m128 y[3];
+		__m128 nearPlain = zero;
+		for (int k = 0; k < 3; ++k)
+		{
+			if constexpr (PlainAxis::Rotated == Axis)
+			{
+				const __m128 px = _mm_loadu_ps(triangles.Coords(k, 0) + i);
+				const __m128 py = _mm_loadu_ps(triangles.Coords(k, 1) + i);
+				const __m128 pz = _mm_loadu_ps(triangles.Coords(k, 2) + i);
+				y[k] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, px), _mm_mul_ps(m1, py)), _mm_mul_ps(m2, pz)), distance);
+				nearPlain = _mm_or_ps(nearPlain, _mm_cmple_ps(_mm_and_ps(y[k], absMask), heightError));
+			}
+			else
+			{
+				y[k] = _mm_sub_ps(FrameCoordSse41<Axis, 1>(triangles, k, i), distance);
+			}
+			y[k] = _mm_blendv_ps(y[k], smallest, _mm_cmpeq_ps(y[k], zero));
+		}
+		if (0 != (_mm_movemask_ps(nearPlain) & laneBits))
+		{
+			points += CountScalar<Axis>(triangles, plainTransform, plainDistFromOrigin, i, std::min<std::size_t>(4, end - i));
+			continue;
+		}
+		points += std::popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(y[0], y[1]), zero)) & laneBits));
+		points += std::popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(y[1], y[2]), zero)) & laneBits));
+		points += std::popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(y[2], y[0]), zero)) & laneBits));
+	}
+	return points;
+}
+
+// permutations moving the lanes selected by an 8 bit mask to the front
+struct CompressPermutations
+{
+	alignas(32) std::int32_t lanes[256][8];
+
+	CompressPermutations()
+		: lanes{}
+	{
+		for (int mask = 0; mask < 256; ++mask)
+			for (int lane = 0, count = 0; lane < 8; ++lane)
+				if (mask & (1 << lane))
+					lanes[mask][count++] = lane;
+	}
+};
+
+static const CompressPermutations s_compressPermutations;
+
+template <PlainAxis Axis, int FrameAxis>
+static inline __m256 FrameCoordAvx2(const TriangleSoA& triangles, int corner, std::size_t i)
+{
+	const __m256 c = _mm256_loadu_ps(triangles.Coords(corner, PlainAxisSource(Axis, FrameAxis)) + i);
+	return PlainAxisNegated(Axis, FrameAxis) ? _mm256_xor_ps(c, _mm256_set1_ps(-0.0f)) : c;
+}
+
+template <PlainAxis Axis>
+static std::size_t SliceAvx2(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output, const mth::float2* outputEnd)
+{
+	__m256 m[3][3];
+	for (int r = 0; r < 3; ++r)
+		for (int c = 0; c < 3; ++c)
+			m[r][c] = _mm256_set1_ps(plainTransform(r, c));
+	const __m256 distance = _mm256_set1_ps(plainDistFromOrigin);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 smallest = _mm256_set1_ps(std::numeric_limits<float>::min());
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const __m256 heightError = _mm256_set1_ps(PlainHeightError(plainTransform, triangles.Magnitude()));
+
+	float* cursor = reinterpret_cast<float*>(output);
+	const float* const cursorEnd = reinterpret_cast<const float*>(outputEnd);
+	const std::size_t end = first + count;
+	for (std::size_t i = first; i < end; i += 8)
+	{
+		const int laneBits = end - i >= 8 ? 0xff : (1 << (end - i)) - 1;
+		__m256 x[3], y[3], z[3];
+		__m256 nearPlain = zero;
+		for (int k = 0; k < 3; ++k)
+		{
+			if constexpr (PlainAxis::Rotated == Axis)
+			{
+				const __m256 px = _mm256_loadu_ps(triangles.Coords(k, 0) + i);
+				const __m256 py = _mm256_loadu_ps(triangles.Coords(k, 1) + i);
+				const __m256 pz = _mm256_loadu_ps(triangles.Coords(k, 2) + i);
+				x[k] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0][0], px), _mm256_mul_ps(m[0][1], py)), _mm256_mul_ps(m[0][2], pz));
+				y[k] = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[1][0], px), _mm256_mul_ps(m[1][1], py)), _mm256_mul_ps(m[1][2], pz)), distance);
+				nearPlain = _mm256_or_ps(nearPlain, _mm256_cmp_ps(_mm256_and_ps(y[k], absMask), heightError, _CMP_LE_OQ));
+				z[k] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[2][0], px), _mm256_mul_ps(m[2][1], py)), _mm256_mul_ps(m[2][2], pz));
+			}
+			else
+			{
+				x[k] = FrameCoordAvx2<Axis, 0>(triangles, k, i);
+				y[k] = _mm256_sub_ps(FrameCoordAvx2<Axis, 1>(triangles, k, i), distance);
+				z[k] = FrameCoordAvx2<Axis, 2>(triangles, k, i);
+			}
+			y[k] = _mm256_blendv_ps(y[k], smallest, _mm256_cmp_ps(y[k], zero, _CMP_EQ_OQ));
+		}
+
+		const __m256 cross01 = _mm256_cmp_ps(_mm256_mul_ps(y[0], y[1]), zero, _CMP_LT_OQ);
+		const __m256 cross12 = _mm256_cmp_ps(_mm256_mul_ps(y[1], y[2]), zero, _CMP_LT_OQ);
+		const __m256 cross20 = _mm256_cmp_ps(_mm256_mul_ps(y[2], y[0]), zero, _CMP_LT_OQ);
+		const int bits01 = _mm256_movemask_ps(cross01) & laneBits;
+		const int bits12 = _mm256_movemask_ps(cross12) & laneBits;
+		const int bits20 = _mm256_movemask_ps(cross20) & laneBits;
+		const int crossed = bits01 | bits12 | bits20;
+		if (0 != (_mm256_movemask_ps(nearPlain) & laneBits) || 0 != (bits01 ^ bits12 ^ bits20))
+		{
+			cursor += 2 * SliceScalarRange<Axis>(triangles, plainTransform, plainDistFromOrigin, i, std::min<std::size_t>(8, end - i), reinterpret_cast<mth::float2*>(cursor));
+			continue;
+		}
+		if (0 == crossed)
+			continue;
+
+		__m256 ex[3], ez[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			const int l = (k + 1) % 3;
+			const __m256 t = _mm256_and_ps(_mm256_div_ps(y[k], _mm256_sub_ps(y[l], y[k])), absMask);
+			ex[k] = _mm256_add_ps(x[k], _mm256_mul_ps(_mm256_sub_ps(x[l], x[k]), t));
+			ez[k] = _mm256_add_ps(z[k], _mm256_mul_ps(_mm256_sub_ps(z[l], z[k]), t));
+		}
+		const __m256 secondOnEdge1 = _mm256_and_ps(cross01, cross12);
+		const __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(s_compressPermutations.lanes[crossed]));
+		const __m256 firstX = _mm256_permutevar8x32_ps(_mm256_blendv_ps(ex[1], ex[0], cross01), permutation);
+		const __m256 firstZ = _mm256_permutevar8x32_ps(_mm256_blendv_ps(ez[1], ez[0], cross01), permutation);
+		const __m256 secondX = _mm256_permutevar8x32_ps(_mm256_blendv_ps(ex[2], ex[1], secondOnEdge1), permutation);
+		const __m256 secondZ = _mm256_permutevar8x32_ps(_mm256_blendv_ps(ez[2], ez[1], secondOnEdge1), permutation);
+
+		// interleave into x0 z0 x1 z1 per triangle, the compressed triangles are stored back to back
+		const __m256 firstLow = _mm256_unpacklo_ps(firstX, firstZ);
+		const __m256 firstHigh = _mm256_unpackhi_ps(firstX, firstZ);
+		const __m256 secondLow = _mm256_unpacklo_ps(secondX, secondZ);
+		const __m256 secondHigh = _mm256_unpackhi_ps(secondX, secondZ);
+		const __m256 t0 = _mm256_shuffle_ps(firstLow, secondLow, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 t1 = _mm256_shuffle_ps(firstLow, secondLow, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 t2 = _mm256_shuffle_ps(firstHigh, secondHigh, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 t3 = _mm256_shuffle_ps(firstHigh, secondHigh, _MM_SHUFFLE(3, 2, 3, 2));
+		const int pointFloats = 4 * std::popcount(static_cast<unsigned>(crossed));
+		if (cursorEnd - cursor >= 32)
+		{
+			_mm256_storeu_ps(cursor + 0, _mm256_permute2f128_ps(t0, t1, 0x20));
+			_mm256_storeu_ps(cursor + 8, _mm256_permute2f128_ps(t2, t3, 0x20));
+			_mm256_storeu_ps(cursor + 16, _mm256_permute2f128_ps(t0, t1, 0x31));
+			_mm256_storeu_ps(cursor + 24, _mm256_permute2f128_ps(t2, t3, 0x31));
+		}
+		else
+		{
+			// close to the end of the output the stores go through a buffer, so nothing past the last point is touched
+			alignas(32) float staging[32];
+			_mm256_store_ps(staging + 0, _mm256_permute2f128_ps(t0, t1, 0x20));
+			_mm256_store_ps(staging + 8, _mm256_permute2f128_ps(t2, t3, 0x20));
+			_mm256_store_ps(staging + 16, _mm256_permute2f128_ps(t0, t1, 0x31));
+			_mm256_store_ps(staging + 24, _mm256_permute2f128_ps(t2, t3, 0x31));
+			std::memcpy(cursor, staging, pointFloats * sizeof(float));
+		}
+		cursor += pointFloats;
+	}
+	return static_cast<std::size_t>(reinterpret_cast<mth::float2*>(cursor) - output);
+}
+
+template <PlainAxis Axis>
+static std::size_t CountAvx2(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count)
+{
+	const __m256 m0 = _mm256_set1_ps(plainTransform(1, 0));
+	const __m256 m1 = _mm256_set1_ps(plainTransform(1, 1));
+	const __m256 m2 = _mm256_set1_ps(plainTransform(1, 2));
+	const __m256 distance = _mm256_set1_ps(plainDistFromOrigin);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 smallest = _mm256_set1_ps(std::numeric_limits<float>::min());
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const __m256 heightError = _mm256_set1_ps(PlainHeightError(plainTransform, triangles.Magnitude()));
+
+	std::size_t points = 0;
+	const std::size_t end = first + count;
+	for (std::size_t i = first; i < end; i += 8)
+	{
+		const int laneBits = end - i >= 8 ? 0xff : (1 << (end - i)) - 1;
+		__m256 y[3];
+		__m256 nearPlain = zero;
+		for (int k = 0; k < 3; ++k)
+		{
+			if constexpr (PlainAxis::Rotated == Axis)
+			{
+				const __m256 px = _mm256_loadu_ps(triangles.Coords(k, 0) + i);
+				const __m256 py = _mm256_loadu_ps(triangles.Coords(k, 1) + i);
+				const __m256 pz = _mm256_loadu_ps(triangles.Coords(k, 2) + i);
+				y[k] = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, px), _mm256_mul_ps(m1, py)), _mm256_mul_ps(m2, pz)), distance);
+				nearPlain = _mm256_or_ps(nearPlain, _mm256_cmp_ps(_mm256_and_ps(y[k], absMask), heightError, _CMP_LE_OQ));
+			}
+			else
+			{
+				y[k] = _mm256_sub_ps(FrameCoordAvx2<Axis, 1>(triangles, k, i), distance);
+			}
+			y[k] = _mm256_blendv_ps(y[k], smallest, _mm256_cmp_ps(y[k], zero, _CMP_EQ_OQ));
+		}
+		if (0 != (_mm256_movemask_ps(nearPlain) & laneBits))
+		{
+			points += CountScalar<Axis>(triangles, plainTransform, plainDistFromOrigin, i, std::min<std::size_t>(8, end - i));
+			continue;
+		}
+		points += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_mul_ps(y[0], y[1]), zero, _CMP_LT_OQ)) & laneBits));
+		points += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_mul_ps(y[1], y[2]), zero, _CMP_LT_OQ)) & laneBits));
+		points += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_mul_ps(y[2], y[0]), zero, _CMP_LT_OQ)) & laneBits));
+	}
+	return points;
+}
+
+template <PlainAxis Axis>
+static std::size_t SliceScalar(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output, const mth::float2*)
+{
+	return SliceScalarRange<Axis>(triangles, plainTransform, plainDistFromOrigin, first, count, output);
+}
+
+static constexpr std::size_t s_plainAxisCount = 7;
+
+// indexed by PlainAxis
+struct KernelChoice
+{
+	SliceKernel kernels[s_plainAxisCount];
+	CountKernel counts[s_plainAxisCount];
+	const char* name;
+};
+
+template <template <PlainAxis> typename Kernels>
+static constexpr KernelChoice MakeChoice(const char* name)
+{
+	return {
+		{
+			Kernels<PlainAxis::Rotated>::slice, Kernels<PlainAxis::PositiveX>::slice, Kernels<PlainAxis::NegativeX>::slice, Kernels<PlainAxis::PositiveY>::slice,
+			Kernels<PlainAxis::NegativeY>::slice, Kernels<PlainAxis::PositiveZ>::slice, Kernels<PlainAxis::NegativeZ>::slice
+		},
+		{
+			Kernels<PlainAxis::Rotated>::count, Kernels<PlainAxis::PositiveX>::count, Kernels<PlainAxis::NegativeX>::count, Kernels<PlainAxis::PositiveY>::count,
+			Kernels<PlainAxis::NegativeY>::count, Kernels<PlainAxis::PositiveZ>::count, Kernels<PlainAxis::NegativeZ>::count
+		},
+		name
+	};
+}
+
+template <PlainAxis Axis>
+struct ScalarKernels
+{
+	static constexpr SliceKernel slice = SliceScalar<Axis>;
+	static constexpr CountKernel count = CountScalar<Axis>;
+};
+
+template <PlainAxis Axis>
+struct Sse41Kernels
+{
+	static constexpr SliceKernel slice = SliceSse41<Axis>;
+	static constexpr CountKernel count = CountSse41<Axis>;
+};
+
+template <PlainAxis Axis>
+struct Avx2Kernels
+{
+	static constexpr SliceKernel slice = SliceAvx2<Axis>;
+	static constexpr CountKernel count = CountAvx2<Axis>;
+};
+
+static KernelChoice ChooseKernel()
+{
+	int info[4]{};
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+	__cpuid(info, 1);
+	const bool sse41 = 0 != (info[2] & (1 << 19));
+	const bool osSavesAvx = 0 != (info[2] & (1 << 27)) && 0 != (info[2] & (1 << 28)) && 6 == (_xgetbv(0) & 6);
+	bool avx2 = false;
+	if (osSavesAvx && maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = 0 != (info[1] & (1 << 5));
+	}
+
+	if (avx2)
+		return MakeChoice<Avx2Kernels>("avx2");
+	if (sse41)
+		return MakeChoice<Sse41Kernels>("sse4.1");
+	return MakeChoice<ScalarKernels>("scalar");
+}
+
+static const KernelChoice s_kernel = ChooseKernel();
+
+std::size_t SliceOutputCapacity(std::size_t triangleCount)
+{
+	return 2 * triangleCount + s_outputSlack;
+}
+
+std::size_t SliceTriangles(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output)
+{
+	const SliceKernel kernel = s_kernel.kernels[static_cast<int>(PlainAxisOf(plainTransform))];
+	return kernel(triangles, plainTransform, plainDistFromOrigin, first, count, output, output + SliceOutputCapacity(count));
+}
+
+std::size_t CountSliceTriangles(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count)
+{
+	const CountKernel kernel = s_kernel.counts[static_cast<int>(PlainAxisOf(plainTransform))];
+	return kernel(triangles, plainTransform, plainDistFromOrigin, first, count);
+}
+
+void SliceTrianglesExact(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output, std::size_t pointCount)
+{
+	const SliceKernel kernel = s_kernel.kernels[static_cast<int>(PlainAxisOf(plainTransform))];
+	kernel(triangles, plainTransform, plainDistFromOrigin, first, count, output, output + pointCount);
+}
+
+const char* SliceKernelName()
+{
+	return s_kernel.name;
+}
\ No newline at end of file
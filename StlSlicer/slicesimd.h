@@ -0,0 +1,36 @@
+#pragma once
+
+#include "mesh.h"
+#include <vector>
+#include <cstddef>
+
+// Corner coordinates of the triangles in nine separate arrays, so a vector register holds one coordinate of several triangles.
+// Every array is followed by padding, so a kernel can load a full register past the last triangle.
+class TriangleSoA
+{
+	std::vector<float> m_coords;
+	std::size_t m_count;
+	std::size_t m_stride;
+	float m_magnitude;
+
+public:
+	TriangleSoA(const IndexedMesh& mesh);
+
+	inline std::size_t Count() const { return m_count; }
+	inline const float* Coords(int corner, int axis) const { return m_coords.data() + (3 * corner + axis) * m_stride; }
+	// the largest absolute coordinate of the mesh, bounds the rounding error of the heights the kernels compute
+	inline float Magnitude() const { return m_magnitude; }
+};
+
+// Room the output of SliceTriangles needs for the given number of triangles, vector stores may write past the last point.
+std::size_t SliceOutputCapacity(std::size_t triangleCount);
+// Slices triangles [first, first + count) in order with the widest kernel the processor supports,
+// writing the same points as CalculateTriangleSlice. Returns the number of points written.
+std::size_t SliceTriangles(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output);
+// Number of points SliceTriangles writes for the same triangles, without computing them.
+std::size_t CountSliceTriangles(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count);
+// Writes the pointCount points CountSliceTriangles reported and nothing past them,
+// so the outputs of neighbouring ranges can share one buffer.
+void SliceTrianglesExact(const TriangleSoA& triangles, const mth::float3x3& plainTransform, float plainDistFromOrigin, std::size_t first, std::size_t count, mth::float2* output, std::size_t pointCount);
+// "avx2", "sse4.1" or "scalar"
+const char* SliceKernelName();
\ No newline at end of file
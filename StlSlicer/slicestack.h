@@ -0,0 +1,21 @@
+#pragma once
+
+#include "math/position.hpp"
+#include <vector>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+// The segments of a stack of layers in one array. Layers with the same cross-section share their points,
+// layer i shows shape layerShapes[i] and shape s owns points [shapeOffsets[s], shapeOffsets[s + 1]).
+struct SliceStack
+{
+	std::vector<mth::float2> points;
+	std::vector<std::size_t> shapeOffsets;
+	std::vector<std::uint32_t> layerShapes;
+
+	inline std::size_t LayerCount() const { return layerShapes.size(); }
+	inline std::size_t ShapeCount() const { return shapeOffsets.empty() ? 0 : shapeOffsets.size() - 1; }
+	inline std::span<const mth::float2> Shape(std::size_t shape) const { return { points.data() + shapeOffsets[shape], points.data() + shapeOffsets[shape + 1] }; }
+	inline std::span<const mth::float2> Layer(std::size_t layer) const { return Shape(layerShapes[layer]); }
+};
\ No newline at end of file
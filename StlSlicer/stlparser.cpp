@@ -0,0 +1,187 @@
+#include "stlparser.h"
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+enum class Match
+{
+	Yes,
+	No,
+	Incomplete
+};
+
+static inline bool IsSpace(char c)
+{
+	return ' ' == c || '\n' == c || '\r' == c || '\t' == c || '\v' == c || '\f' == c;
+}
+
+static inline const char* SkipSpace(const char* cursor, const char* end)
+{
+	while (cursor < end && IsSpace(*cursor))
+		++cursor;
+	return cursor;
+}
+
+template <std::size_t N>
+static Match MatchKeyword(const char*& cursor, const char* end, const char(&keyword)[N])
+{
+	constexpr std::size_t length = N - 1;
+	const char* c = SkipSpace(cursor, end);
+	const std::size_t available = static_cast<std::size_t>(end - c);
+	// a keyword is only complete once the whitespace after it has been seen
+	if (available <= length)
+		return 0 == available || 0 == std::memcmp(c, keyword, available) ? Match::Incomplete : Match::No;
+	if (0 != std::memcmp(c, keyword, length) || !IsSpace(c[length]))
+		return Match::No;
+	cursor = c + length;
+	return Match::Yes;
+}
+
+static Match ParseFloat(const char*& cursor, const char* end, float& value)
+{
+	const char* first = SkipSpace(cursor, end);
+	if (first < end && '+' == *first)
+		++first;
+	if (first == end)
+		return Match::Incomplete;
+
+	std::from_chars_result result = std::from_chars(first, end, value);
+	if (std::errc::invalid_argument == result.ec || (end != result.ptr && !IsSpace(*result.ptr)))
+	{
+		// a number cut short by the end of the data ("-", "1e") may still turn out valid
+		const char* tokenEnd = std::find_if(first, end, IsSpace);
+		return end == tokenEnd ? Match::Incomplete : Match::No;
+	}
+	if (end == result.ptr)
+		return Match::Incomplete;
+	if (std::errc::result_out_of_range == result.ec)
+	{
+		// from_chars leaves the value untouched on overflow and underflow, strtof saturates them
+		char token[64]{};
+		std::memcpy(token, first, std::min(sizeof(token) - 1, static_cast<std::size_t>(result.ptr - first)));
+		value = std::strtof(token, nullptr);
+	}
+	cursor = result.ptr;
+	return Match::Yes;
+}
+
+static Match ParseFloat3(const char*& cursor, const char* end, mth::float3& v)
+{
+	Match match = ParseFloat(cursor, end, v.x);
+	if (Match::Yes == match)
+		match = ParseFloat(cursor, end, v.y);
+	if (Match::Yes == match)
+		match = ParseFloat(cursor, end, v.z);
+	return match;
+}
+
+mth::float3 StlConvert(mth::float3 v)
+{
+	return mth::float3(v.y, v.z, v.x);
+}
+
+std::uint32_t StlBinFaceCount(const char* data)
+{
+	std::uint32_t faceCount;
+	std::memcpy(&faceCount, data + StlBinHeaderSize - sizeof(faceCount), sizeof(faceCount));
+	return faceCount;
+}
+
+bool IsBinaryStl(const char* data, std::size_t size)
+{
+	if (size < StlBinHeaderSize)
+		return false;
+	const std::uint64_t expectedSize = StlBinHeaderSize + StlBinFacetSize * static_cast<std::uint64_t>(StlBinFaceCount(data));
+	if (expectedSize == size)
+		return true;
+	// some exporters write "solid" into the binary header too, so only trust the keyword when the size does not match
+	return expectedSize < size && 0 != std::memcmp(data, "solid", 5);
+}
+
+void DecodeStlBinFacets(Vertex* output, const char* facets, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i, facets += StlBinFacetSize)
+	{
+		float values[12];
+		std::memcpy(values, facets, sizeof(values));
+		const mth::float3 normal = StlConvert(mth::float3(values));
+		output[3 * i + 0] = { StlConvert(mth::float3(values + 3)), normal };
+		output[3 * i + 1] = { StlConvert(mth::float3(values + 6)), normal };
+		output[3 * i + 2] = { StlConvert(mth::float3(values + 9)), normal };
+	}
+}
+
+const char* SkipStlTextHeader(const char* begin, const char* end)
+{
+	if (begin == end)
+		return end;
+	const char* lineEnd = static_cast<const char*>(std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+	return lineEnd ? lineEnd + 1 : end;
+}
+
+const char* FindStlTextFacet(const char* begin, const char* end)
+{
+	// "facet" as a whole word, so the tail of "endfacet" does not count
+	for (const char* c = begin; end - c > 5; ++c)
+	{
+		c = static_cast<const char*>(std::memchr(c, 'f', static_cast<std::size_t>(end - c - 5)));
+		if (nullptr == c)
+			break;
+		if (c > begin && IsSpace(c[-1]) && 0 == std::memcmp(c, "facet", 5) && IsSpace(c[5]))
+			return c;
+	}
+	return end;
+}
+
+StlTextResult ParseStlTextFacet(const char*& cursor, const char* end, Vertex output[3])
+{
+	const char* c = SkipSpace(cursor, end);
+	if (c == end)
+	{
+		cursor = end;
+		return StlTextResult::EndOfData;
+	}
+	if (end - c >= 8 && 0 == std::memcmp(c, "endsolid", 8))
+	{
+		cursor = c + 8;
+		return StlTextResult::EndSolid;
+	}
+	if (end - c < 8 && 0 == std::memcmp(c, "endsolid", static_cast<std::size_t>(end - c)))
+		return StlTextResult::Incomplete;
+
+	mth::float3 normal;
+	Match match = MatchKeyword(c, end, "facet");
+	if (Match::Yes == match)
+		match = MatchKeyword(c, end, "normal");
+	if (Match::Yes == match)
+		match = ParseFloat3(c, end, normal);
+	if (Match::Yes == match)
+		match = MatchKeyword(c, end, "outer");
+	if (Match::Yes == match)
+		match = MatchKeyword(c, end, "loop");
+	for (int i = 0; i < 3 && Match::Yes == match; ++i)
+	{
+		match = MatchKeyword(c, end, "vertex");
+		if (Match::Yes == match)
+			match = ParseFloat3(c, end, output[i].position);
+	}
+	if (Match::Yes == match)
+		match = MatchKeyword(c, end, "endloop");
+	if (Match::Yes == match)
+		match = MatchKeyword(c, end, "endfacet");
+
+	if (Match::Incomplete == match)
+		return StlTextResult::Incomplete;
+	if (Match::No == match)
+		return StlTextResult::Invalid;
+
+	normal = StlConvert(normal);
+	for (int i = 0; i < 3; ++i)
+	{
+		output[i].position = StlConvert(output[i].position);
+		output[i].normal = normal;
+	}
+	cursor = c;
+	return StlTextResult::Facet;
+}
\ No newline at end of file
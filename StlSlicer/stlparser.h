@@ -0,0 +1,26 @@
+#pragma once
+
+#include "mesh.h"
+#include <cstdint>
+
+constexpr std::size_t StlBinHeaderSize = 84;
+constexpr std::size_t StlBinFacetSize = 50;
+
+enum class StlTextResult
+{
+	Facet,
+	EndSolid,
+	EndOfData,
+	Incomplete,
+	Invalid
+};
+
+mth::float3 StlConvert(mth::float3 v);
+
+std::uint32_t StlBinFaceCount(const char* data);
+bool IsBinaryStl(const char* data, std::size_t size);
+void DecodeStlBinFacets(Vertex* output, const char* facets, std::size_t count);
+
+const char* SkipStlTextHeader(const char* begin, const char* end);
+const char* FindStlTextFacet(const char* begin, const char* end);
+StlTextResult ParseStlTextFacet(const char*& cursor, const char* end, Vertex output[3]);
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "stlstream.h"
+#include "stlparser.h"
+#include "inflate.h"
+#include <condition_variable>
+#include <mutex>
+#include <deque>
+#include <future>
+#include <algorithm>
+#include <cstring>
+
+static constexpr std::size_t s_queuedBlocks = 8;
+static constexpr std::size_t s_maxTextHeaderLine = 4096;	// a "solid" header without a line break this long is binary
+
+enum class StlTextStart
+{
+	Text,
+	Binary,
+	Undecided	// more data is needed
+};
+
+// a text STL goes on with "facet" or "endsolid" after its first line, binary facets hardly ever do
+static StlTextStart CheckStlTextStart(const char* begin, const char* end, bool endOfStream)
+{
+	const char* lineEnd = static_cast<const char*>(std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+	if (nullptr == lineEnd)
+	{
+		if (static_cast<std::size_t>(end - begin) > s_maxTextHeaderLine)
+			return StlTextStart::Binary;
+		return endOfStream ? StlTextStart::Text : StlTextStart::Undecided;
+	}
+	const char* cursor = lineEnd + 1;
+	while (cursor < end && (' ' == *cursor || '\n' == *cursor || '\r' == *cursor || '\t' == *cursor || '\v' == *cursor || '\f' == *cursor))
+		++cursor;
+	const std::size_t available = static_cast<std::size_t>(end - cursor);
+	for (const char* keyword : { "facet", "endsolid" })
+	{
+		const std::size_t length = std::strlen(keyword);
+		if (0 != std::memcmp(cursor, keyword, std::min(length, available)))
+			continue;
+		// a keyword cut off by the end of the data so far may still complete
+		return available >= length || endOfStream ? StlTextStart::Text : StlTextStart::Undecided;
+	}
+	return StlTextStart::Binary;
+}
+
+struct StreamBlock
+{
+	std::vector<char> data;
+	std::size_t consumed;	// compressed bytes read to produce the stream up to the end of this block
+};
+
+// Bounded queue between the decompressing and the parsing thread.
+class BlockQueue
+{
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::deque<StreamBlock> m_blocks;
+	bool m_closed;
+	bool m_abandoned;
+
+public:
+	BlockQueue()
+		: m_closed{}
+		, m_abandoned{} {}
+
+	bool Push(StreamBlock&& block)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this]() { return m_abandoned || m_blocks.size() < s_queuedBlocks; });
+		if (m_abandoned)
+			return false;
+		m_blocks.push_back(std::move(block));
+		m_changed.notify_all();
+		return true;
+	}
+
+	bool Pop(StreamBlock& block)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this]() { return m_closed || !m_blocks.empty(); });
+		if (m_blocks.empty())
+			return false;
+		block = std::move(m_blocks.front());
+		m_blocks.pop_front();
+		m_changed.notify_all();
+		return true;
+	}
+
+	// no more blocks are coming
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+		m_changed.notify_all();
+	}
+
+	// no more blocks are needed
+	void Abandon()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_abandoned = true;
+		m_changed.notify_all();
+	}
+};
+
+StlStreamParser::StlStreamParser(std::uint64_t sizeHint)
+	: m_sizeHint{ sizeHint }
+	, m_remainingFacets{}
+	, m_format{ Format::Unknown }
+	, m_finished{} {}
+
+void StlStreamParser::DetectFormat(bool endOfStream)
+{
+	if (m_pending.size() < StlBinHeaderSize)
+	{
+		// nothing shorter than a binary header can be binary
+		if (endOfStream)
+			m_format = Format::TextHeader;
+		return;
+	}
+
+	// same rules as IsBinaryStl, with the total size only known modulo 2^32
+	const std::uint64_t faceCount = StlBinFaceCount(m_pending.data());
+	const std::uint64_t expectedSize = StlBinHeaderSize + StlBinFacetSize * faceCount;
+	bool binary = static_cast<std::uint32_t>(expectedSize) == static_cast<std::uint32_t>(m_sizeHint) || 0 != std::memcmp(m_pending.data(), "solid", 5);
+	if (!binary)
+	{
+		// the size hint only covers the last member of a multi member gzip, so a "solid" header is checked on the content as well
+		const StlTextStart start = CheckStlTextStart(m_pending.data(), m_pending.data() + m_pending.size(), endOfStream);
+		if (StlTextStart::Undecided == start)
+			return;
+		binary = StlTextStart::Binary == start;
+	}
+	if (!binary)
+	{
+		m_format = Format::TextHeader;
+		return;
+	}
+
+	m_format = Format::Binary;
+	m_remainingFacets = faceCount;
+	m_vertices.reserve(3 * static_cast<std::size_t>(std::min(faceCount, m_sizeHint / StlBinFacetSize + 1)));
+	m_pending.erase(m_pending.begin(), m_pending.begin() + StlBinHeaderSize);
+}
+
+bool StlStreamParser::ParseBinary(bool endOfStream)
+{
+	const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(m_pending.size() / StlBinFacetSize, m_remainingFacets));
+	const std::size_t first = m_vertices.size();
+	m_vertices.resize(first + 3 * count);
+	DecodeStlBinFacets(m_vertices.data() + first, m_pending.data(), count);
+	m_remainingFacets -= count;
+
+	if (0 == m_remainingFacets)
+	{
+		// bytes after the last facet are ignored, like in files loaded directly
+		m_finished = true;
+		m_pending.clear();
+		return true;
+	}
+	m_pending.erase(m_pending.begin(), m_pending.begin() + count * StlBinFacetSize);
+	return !endOfStream;
+}
+
+bool StlStreamParser::ParseText(bool endOfStream)
+{
+	const char* begin = m_pending.data();
+	const char* end = begin + m_pending.size();
+	const char* cursor = begin;
+
+	if (Format::TextHeader == m_format)
+	{
+		if (!endOfStream && nullptr == std::memchr(begin, '\n', m_pending.size()))
+			return true;
+		cursor = SkipStlTextHeader(begin, end);
+		m_format = Format::Text;
+	}
+
+	Vertex facet[3];
+	while (true)
+	{
+		const StlTextResult result = ParseStlTextFacet(cursor, end, facet);
+		if (StlTextResult::Facet == result)
+		{
+			m_vertices.insert(m_vertices.end(), facet, facet + 3);
+			continue;
+		}
+		if (StlTextResult::EndSolid == result)
+		{
+			m_finished = true;
+			m_pending.clear();
+			return true;
+		}
+		if (StlTextResult::Invalid == result)
+			return false;
+		// incomplete, the next block continues the facet
+		break;
+	}
+
+	m_pending.erase(m_pending.begin(), m_pending.begin() + (cursor - begin));
+	return !endOfStream;
+}
+
+bool StlStreamParser::Parse(bool endOfStream)
+{
+	if (Format::Unknown == m_format)
+		DetectFormat(endOfStream);
+	if (Format::Unknown == m_format)
+		return true;
+	return Format::Binary == m_format ? ParseBinary(endOfStream) : ParseText(endOfStream);
+}
+
+bool StlStreamParser::Feed(const char* data, std::size_t size)
+{
+	if (m_finished)
+		return true;
+	m_pending.insert(m_pending.end(), data, data + size);
+	return Parse(false);
+}
+
+bool StlStreamParser::Finish()
+{
+	return m_finished || Parse(true);
+}
+
+std::vector<Vertex> StlStreamParser::TakeVertices()
+{
+	return std::move(m_vertices);
+}
+
+StlCompression DetectStlCompression(const char* data, std::size_t size)
+{
+	if (IsGzip(data, size))
+		return StlCompression::Gzip;
+	if (IsZstd(data, size))
+		return StlCompression::Zstd;
+	return StlCompression::None;
+}
+
+bool ParseCompressedStl(const char* data, std::size_t size, std::vector<Vertex>& vertices, LoadProgress* progress)
+{
+	if (StlCompression::Gzip != DetectStlCompression(data, size))
+		return false;
+
+	BlockQueue queue;
+	std::future<bool> inflated = std::async(std::launch::async, [&queue, data, size]() {
+		bool result = false;
+		try
+		{
+			result = InflateGzip(data, size, [&queue](const char* block, std::size_t count, std::size_t consumed) {
+				return queue.Push({ std::vector<char>(block, block + count), consumed });
+				});
+		}
+		catch (...)
+		{
+			queue.Close();
+			throw;
+		}
+		queue.Close();
+		return result;
+		});
+
+	StlStreamParser parser(GzipSizeHint(data, size));
+	StreamBlock block{};
+	std::size_t reported = 0;
+	bool parsed = true;
+	try
+	{
+		while (parsed && queue.Pop(block))
+		{
+			parsed = parser.Feed(block.data.data(), block.data.size());
+			if (progress)
+			{
+				progress->Advance(block.consumed - reported);
+				reported = block.consumed;
+				parsed = parsed && !progress->IsCancelled();
+			}
+		}
+	}
+	catch (...)
+	{
+		queue.Abandon();	// otherwise the future waits on a thread stuck pushing to the full queue
+		throw;
+	}
+	queue.Abandon();	// lets the decompressing thread stop when parsing failed
+
+	if (!inflated.get() || !parsed || !parser.Finish())
+		return false;
+	vertices = parser.TakeVertices();
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "mesh.h"
+#include "loadprogress.h"
+#include <vector>
+#include <cstdint>
+
+// Parses a binary or text STL that arrives in consecutive blocks of any size.
+// Only the unparsed tail of the previous block is kept between two calls.
+class StlStreamParser
+{
+	enum class Format
+	{
+		Unknown,
+		Binary,
+		TextHeader,
+		Text
+	};
+
+	std::vector<char> m_pending;
+	std::vector<Vertex> m_vertices;
+	std::uint64_t m_sizeHint;
+	std::uint64_t m_remainingFacets;
+	Format m_format;
+	bool m_finished;	// every facet has been read, the rest of the stream is ignored
+
+private:
+	void DetectFormat(bool endOfStream);
+	bool ParseBinary(bool endOfStream);
+	bool ParseText(bool endOfStream);
+	bool Parse(bool endOfStream);
+
+public:
+	// the size hint is the decompressed size modulo 2^32, it tells binary files with "solid" in their header apart,
+	// when it does not match the line after such a header decides
+	StlStreamParser(std::uint64_t sizeHint);
+
+	bool Feed(const char* data, std::size_t size);
+	bool Finish();
+	std::vector<Vertex> TakeVertices();
+};
+
+enum class StlCompression
+{
+	None,
+	Gzip,
+	Zstd
+};
+
+StlCompression DetectStlCompression(const char* data, std::size_t size);
+// Decompresses a gzip STL on a separate thread while the calling thread parses the decompressed blocks.
+bool ParseCompressedStl(const char* data, std::size_t size, std::vector<Vertex>& vertices, LoadProgress* progress);
\ No newline at end of file
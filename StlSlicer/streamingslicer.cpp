@@ -0,0 +1,340 @@
+#include "streamingslicer.h"
+#include "filemapping.h"
+#include "stlparser.h"
+#include "slicekernel.h"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+static constexpr std::size_t s_minWindowSize = 1 << 20;
+static constexpr std::size_t s_minBucketBuffer = 1 << 10;
+
+struct StreamedTriangle
+{
+	float coords[9];
+
+	inline mth::float3 Position(int i) const { return mth::float3(coords + 3 * i); }
+};
+
+class TriangleReader
+{
+	FileMapping m_file;
+	std::size_t m_windowSize;
+	std::uint64_t m_dataOffset;
+	std::uint64_t m_dataEnd;
+	std::uint64_t m_offset;
+	bool m_binary;
+	bool m_finished;
+
+private:
+	bool ReadBin(std::vector<StreamedTriangle>& block, std::size_t capacity)
+	{
+		const std::uint64_t remaining = (m_dataEnd - m_offset) / StlBinFacetSize;
+		const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, std::min(capacity, m_windowSize / StlBinFacetSize)));
+		if (0 == count)
+		{
+			m_finished = true;
+			return true;
+		}
+		if (!m_file.MapRange(m_offset, count * StlBinFacetSize))
+			return false;
+
+		block.resize(count);
+		const char* facet = m_file.Data();
+		for (std::size_t i = 0; i < count; ++i, facet += StlBinFacetSize)
+		{
+			float values[9];
+			std::memcpy(values, facet + 3 * sizeof(float), sizeof(values));
+			for (int j = 0; j < 3; ++j)
+			{
+				const mth::float3 p = StlConvert(mth::float3(values + 3 * j));
+				std::memcpy(block[i].coords + 3 * j, &p.x, 3 * sizeof(float));
+			}
+		}
+		m_offset += count * StlBinFacetSize;
+		return true;
+	}
+
+	bool ReadText(std::vector<StreamedTriangle>& block, std::size_t capacity)
+	{
+		Vertex facet[3];
+		while (block.size() < capacity)
+		{
+			if (!m_file.MapRange(m_offset, m_windowSize))
+				return false;
+			const bool lastWindow = m_offset + m_file.MappedSize() == m_file.FileSize();
+			const char* begin = m_file.Data();
+			const char* end = begin + m_file.MappedSize();
+			const char* cursor = begin;
+
+			StlTextResult result = StlTextResult::Facet;
+			while (block.size() < capacity && StlTextResult::Facet == (result = ParseStlTextFacet(cursor, end, facet)))
+			{
+				StreamedTriangle& triangle = block.emplace_back();
+				for (int j = 0; j < 3; ++j)
+					std::memcpy(triangle.coords + 3 * j, &facet[j].position.x, 3 * sizeof(float));
+			}
+			m_offset += static_cast<std::uint64_t>(cursor - begin);
+
+			if (StlTextResult::EndSolid == result)
+			{
+				m_finished = true;
+				return true;
+			}
+			if (StlTextResult::Invalid == result)
+				return false;
+			// a facet cut by the window end is parsed again from the next window, unless it cannot grow any further
+			if (StlTextResult::Facet != result && (lastWindow || (cursor == begin && StlTextResult::Incomplete == result)))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	TriangleReader(std::size_t windowSize)
+		: m_windowSize{ std::max(windowSize, s_minWindowSize) }
+		, m_dataOffset{}
+		, m_dataEnd{}
+		, m_offset{}
+		, m_binary{}
+		, m_finished{} {}
+
+	bool Open(const wchar_t* filename)
+	{
+		if (!m_file.Open(filename, false) || !m_file.MapRange(0, s_minWindowSize))
+			return false;
+		m_binary = IsBinaryStl(m_file.Data(), m_file.Size());
+		if (m_binary)
+		{
+			m_dataOffset = StlBinHeaderSize;
+			m_dataEnd = StlBinHeaderSize + StlBinFacetSize * static_cast<std::uint64_t>(StlBinFaceCount(m_file.Data()));
+		}
+		else
+		{
+			m_dataOffset = static_cast<std::uint64_t>(SkipStlTextHeader(m_file.Data(), m_file.Data() + m_file.MappedSize()) - m_file.Data());
+			m_dataEnd = m_file.FileSize();
+		}
+		Rewind();
+		return true;
+	}
+
+	void Rewind()
+	{
+		m_offset = m_dataOffset;
+		m_finished = false;
+	}
+
+	// an empty block after a successful read means the end of the model
+	bool Read(std::vector<StreamedTriangle>& block, std::size_t capacity)
+	{
+		block.clear();
+		if (m_finished)
+			return true;
+		return m_binary ? ReadBin(block, capacity) : ReadText(block, capacity);
+	}
+};
+
+class TemporaryDirectory
+{
+	std::filesystem::path m_path;
+
+public:
+	// the path stays empty if the directory could not be created
+	TemporaryDirectory()
+	{
+		std::error_code error;
+		const std::filesystem::path parent = std::filesystem::temp_directory_path(error);
+		if (error)
+			return;
+		std::random_device random;
+		const std::filesystem::path path = parent / (L"StlSlicer-" + std::to_wstring(random()) + std::to_wstring(random()));
+		if (std::filesystem::create_directories(path, error) && !error)
+			m_path = path;
+	}
+	~TemporaryDirectory()
+	{
+		std::error_code error;
+		if (!m_path.empty())
+			std::filesystem::remove_all(m_path, error);
+	}
+
+	inline bool Created() const { return !m_path.empty(); }
+	inline const std::filesystem::path& Path() const { return m_path; }
+};
+
+struct LayerBucket
+{
+	unsigned firstLayer;
+	unsigned lastLayer;
+	std::uint64_t triangleCount;
+	std::filesystem::path filename;
+	std::vector<StreamedTriangle> buffer;
+
+	bool Flush()
+	{
+		if (buffer.empty())
+			return true;
+		// buckets are reopened on every flush, there can be more of them than open file handles
+		std::ofstream outfile(filename, std::ios::binary | std::ios::app);
+		outfile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(StreamedTriangle));
+		buffer.clear();
+		return outfile.good();
+	}
+};
+
+static bool LayerRange(const StreamingSliceSettings& settings, const mth::float3x3& plainTransform, const StreamedTriangle& triangle, unsigned& firstLayer, unsigned& lastLayer)
+{
+	const float h0 = PlainHeight(plainTransform, triangle.Position(0));
+	const float h1 = PlainHeight(plainTransform, triangle.Position(1));
+	const float h2 = PlainHeight(plainTransform, triangle.Position(2));
+	// the kernel may put a corner on the other side of a plain its rounded height misses by less than the error
+	const float heightError = std::max({ PlainHeightError(plainTransform, triangle.Position(0)), PlainHeightError(plainTransform, triangle.Position(1)), PlainHeightError(plainTransform, triangle.Position(2)) });
+	return PlainLayerRange(std::min({ h0, h1, h2 }) - heightError, std::max({ h0, h1, h2 }) + heightError, settings.firstPlainDistance, settings.layerDistance, settings.layerCount, firstLayer, lastLayer);
+}
+
+StreamingSlicer::StreamingSlicer(const StreamingSliceSettings& settings)
+	: m_settings(settings) {}
+
+bool StreamingSlicer::Slice(const wchar_t* filename, const LayerHandler& handler) const
+{
+	if (0 == m_settings.layerCount || !(m_settings.layerDistance > 0.0f))
+		return false;
+
+	// budget split: input block, bucket write buffers, and the triangles of the bucket being sliced
+	const std::size_t blockCapacity = std::max<std::size_t>(1, m_settings.memoryBudget / 8 / sizeof(StreamedTriangle));
+	const std::size_t writeCapacity = std::max<std::size_t>(1, m_settings.memoryBudget / 4 / sizeof(StreamedTriangle));
+	const std::uint64_t bucketCapacity = std::max<std::size_t>(1, m_settings.memoryBudget / 2 / (sizeof(StreamedTriangle) + 3 * sizeof(unsigned)));
+
+	const mth::float3x3 plainTransform = PlainTransform(m_settings.plainNormal);
+	TriangleReader reader(blockCapacity * sizeof(StreamedTriangle));
+	if (!reader.Open(filename))
+		return false;
+	std::vector<StreamedTriangle> block;
+	block.reserve(blockCapacity);
+	unsigned firstLayer, lastLayer;
+
+	// first pass: how many triangles start and end at each layer
+	std::vector<std::uint64_t> startCount(m_settings.layerCount);
+	std::vector<std::uint64_t> endCount(m_settings.layerCount);
+	do
+	{
+		if (!reader.Read(block, blockCapacity))
+			return false;
+		for (const StreamedTriangle& triangle : block)
+		{
+			if (LayerRange(m_settings, plainTransform, triangle, firstLayer, lastLayer))
+			{
+				++startCount[firstLayer];
+				++endCount[lastLayer];
+			}
+		}
+	} while (!block.empty());
+
+	// group consecutive layers while the triangles touching the group fit into the budget,
+	// triangles touching layers [p, q] = (started at or before q) - (ended before p)
+	// a bucket holds at least one layer, so a layer crossed by more triangles than the budget holds gets a bucket over it
+	TemporaryDirectory directory;
+	if (!directory.Created())
+		return false;
+	std::vector<LayerBucket> buckets;
+	std::uint64_t started = 0;
+	std::uint64_t ended = 0;
+	std::uint64_t bucketEndedBefore = 0;
+	for (unsigned layer = 0; layer < m_settings.layerCount; ++layer)
+	{
+		started += startCount[layer];
+		if (buckets.empty() || (started - bucketEndedBefore > bucketCapacity && buckets.back().firstLayer < layer))
+		{
+			bucketEndedBefore = ended;
+			LayerBucket& bucket = buckets.emplace_back();
+			bucket.firstLayer = layer;
+			bucket.filename = directory.Path() / (std::to_wstring(buckets.size() - 1) + L".bin");
+		}
+		buckets.back().lastLayer = layer;
+		buckets.back().triangleCount = started - bucketEndedBefore;
+		ended += endCount[layer];
+	}
+	startCount = std::vector<std::uint64_t>();
+	endCount = std::vector<std::uint64_t>();
+
+	// second pass: copy every triangle into each bucket it touches
+	const std::size_t bucketBufferCapacity = std::max(s_minBucketBuffer, writeCapacity / buckets.size());
+	reader.Rewind();
+	do
+	{
+		if (!reader.Read(block, blockCapacity))
+			return false;
+		for (const StreamedTriangle& triangle : block)
+		{
+			if (!LayerRange(m_settings, plainTransform, triangle, firstLayer, lastLayer))
+				continue;
+			auto bucket = std::upper_bound(buckets.begin(), buckets.end(), firstLayer, [](unsigned layer, const LayerBucket& b) { return layer < b.firstLayer; }) - 1;
+			for (; buckets.end() != bucket && bucket->firstLayer <= lastLayer; ++bucket)
+			{
+				bucket->buffer.push_back(triangle);
+				if (bucket->buffer.size() >= bucketBufferCapacity && !bucket->Flush())
+					return false;
+			}
+		}
+	} while (!block.empty());
+	block = std::vector<StreamedTriangle>();
+	for (LayerBucket& bucket : buckets)
+	{
+		if (!bucket.Flush())
+			return false;
+		bucket.buffer = std::vector<StreamedTriangle>();
+	}
+
+	// third pass: sweep the layers of each bucket, keeping only the triangles crossing the current layer
+	std::vector<StreamedTriangle> triangles;
+	std::vector<unsigned> triangleFirstLayer;
+	std::vector<unsigned> triangleLastLayer;
+	std::vector<unsigned> order;
+	std::vector<unsigned> active;
+	std::vector<mth::float2> slice;
+	for (const LayerBucket& bucket : buckets)
+	{
+		triangles.resize(static_cast<std::size_t>(bucket.triangleCount));
+		if (!triangles.empty())
+		{
+			std::ifstream infile(bucket.filename, std::ios::binary);
+			infile.read(reinterpret_cast<char*>(triangles.data()), triangles.size() * sizeof(StreamedTriangle));
+			if (!infile.good())
+				return false;
+			infile.close();
+			std::error_code error;
+			if (!std::filesystem::remove(bucket.filename, error))
+				return false;
+		}
+
+		triangleFirstLayer.resize(triangles.size());
+		triangleLastLayer.resize(triangles.size());
+		order.resize(triangles.size());
+		for (unsigned i = 0; i < triangles.size(); ++i)
+		{
+			LayerRange(m_settings, plainTransform, triangles[i], triangleFirstLayer[i], triangleLastLayer[i]);
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [&triangleFirstLayer](unsigned a, unsigned b) { return triangleFirstLayer[a] < triangleFirstLayer[b]; });
+
+		active.clear();
+		std::size_t next = 0;
+		for (unsigned layer = bucket.firstLayer; layer <= bucket.lastLayer; ++layer)
+		{
+			active.erase(std::remove_if(active.begin(), active.end(), [&triangleLastLayer, layer](unsigned i) { return triangleLastLayer[i] < layer; }), active.end());
+			for (; next < order.size() && triangleFirstLayer[order[next]] <= layer; ++next)
+				active.push_back(order[next]);
+
+			const float plainDistance = m_settings.firstPlainDistance + m_settings.layerDistance * static_cast<float>(layer);
+			slice.clear();
+			for (unsigned i : active)
+				CalculateTriangleSlice(slice, plainTransform, plainDistance, triangles[i].Position(0), triangles[i].Position(1), triangles[i].Position(2));
+			handler(layer, slice);
+		}
+	}
+	return true;
+}
\ No newline at end of file
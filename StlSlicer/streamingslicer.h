@@ -0,0 +1,35 @@
+#pragma once
+
+#include "math/position.hpp"
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+struct StreamingSliceSettings
+{
+	mth::float3 plainNormal;
+	float firstPlainDistance;
+	float layerDistance;
+	unsigned layerCount;
+	std::size_t memoryBudget;
+};
+
+// Slices an STL file layer by layer without loading the whole mesh.
+// Triangles are streamed from the file, sorted into on-disk buckets of consecutive layers,
+// and every bucket is sliced on its own, so memory use follows the budget and not the model size.
+// The budget bounds the triangles of a bucket only down to a single layer: a layer crossed by more triangles
+// than the budget holds is still sliced in one piece and takes the memory it needs.
+// Slice returns false if the file cannot be read or the temporary buckets cannot be written, read or removed.
+class StreamingSlicer
+{
+public:
+	using LayerHandler = std::function<void(unsigned layer, const std::vector<mth::float2>& slice)>;
+
+private:
+	StreamingSliceSettings m_settings;
+
+public:
+	StreamingSlicer(const StreamingSliceSettings& settings);
+
+	bool Slice(const wchar_t* filename, const LayerHandler& handler) const;
+};
\ No newline at end of file
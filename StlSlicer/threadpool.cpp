@@ -0,0 +1,117 @@
+#include "threadpool.h"
+
+static thread_local const ThreadPool* t_pool = nullptr;
+static thread_local unsigned t_queue = 0;
+
+unsigned ThreadPool::HomeQueue()
+{
+	// workers keep to their own deque, other threads spread their tasks over all of them
+	if (this == t_pool)
+		return t_queue;
+	return m_nextQueue++ % static_cast<unsigned>(m_queues.size());
+}
+
+bool ThreadPool::RunTask(unsigned home, bool background)
+{
+	Task task;
+	{
+		Queue& own = *m_queues[home];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+		}
+	}
+	for (std::size_t i = 1; !task && i < m_queues.size(); ++i)
+	{
+		Queue& victim = *m_queues[(home + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+		}
+	}
+	if (!task && background)
+	{
+		std::lock_guard<std::mutex> lock(m_background.mutex);
+		if (!m_background.tasks.empty())
+		{
+			task = std::move(m_background.tasks.front());
+			m_background.tasks.pop_front();
+		}
+	}
+	if (!task)
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		--m_queuedCount;
+	}
+	task();
+	return true;
+}
+
+void ThreadPool::WorkerLoop(unsigned index)
+{
+	t_pool = this;
+	t_queue = index;
+	while (true)
+	{
+		if (RunTask(index, true))
+			continue;
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [this]() { return m_stopping || 0 != m_queuedCount; });
+		if (m_stopping && 0 == m_queuedCount)
+			return;
+	}
+}
+
+void ThreadPool::Push(Queue& queue, Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		++m_queuedCount;
+	}
+	m_wake.notify_one();
+}
+
+void ThreadPool::Submit(Task task)
+{
+	Push(m_background, std::move(task));
+}
+
+ThreadPool::ThreadPool(unsigned threadCount)
+	: m_queuedCount{}
+	, m_nextQueue{}
+	, m_stopping{}
+{
+	threadCount = std::max(1u, threadCount);
+	for (unsigned i = 0; i < threadCount; ++i)
+		m_queues.push_back(std::make_unique<Queue>());
+	m_threads.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; ++i)
+		m_threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+	static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+	return pool;
+}
\ No newline at end of file
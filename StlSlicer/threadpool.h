@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Long-lived worker threads with a task deque each. A worker runs the newest task of its own deque
+// and steals the oldest task of another one when its own is empty.
+// Threads waiting for a ParallelFor run queued tasks meanwhile, so loops can be nested in tasks.
+class ThreadPool
+{
+	using Task = std::function<void()>;
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	Queue m_background;	// only idle workers take these, so a waiting ParallelFor never gets stuck behind one
+	std::vector<std::thread> m_threads;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::size_t m_queuedCount;	// guarded by m_sleepMutex
+	std::atomic<unsigned> m_nextQueue;
+	bool m_stopping;
+
+private:
+	unsigned HomeQueue();
+	bool RunTask(unsigned home, bool background);
+	void Push(Queue& queue, Task task);
+	void WorkerLoop(unsigned index);
+
+public:
+	explicit ThreadPool(unsigned threadCount);
+	ThreadPool(const ThreadPool&) = delete;
+	~ThreadPool();
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// one worker per processor besides the thread that calls ParallelFor
+	static ThreadPool& Shared();
+
+	// Runs the task on some worker later, for background work nobody waits for.
+	void Submit(Task task);
+
+	// Calls func(i) for every i in [0, count) and returns when all calls are done.
+	// Indices are handed out one by one, so uneven iterations balance out. The first exception thrown is rethrown.
+	template <typename Func>
+	void ParallelFor(std::size_t count, Func&& func);
+
+	inline unsigned ThreadCount() const { return static_cast<unsigned>(m_threads.size()); }
+};
+
+template <typename Func>
+void ThreadPool::ParallelFor(std::size_t count, Func&& func)
+{
+	if (count < 2)
+	{
+		if (1 == count)
+			func(std::size_t(0));
+		return;
+	}
+
+	struct Loop
+	{
+		std::atomic<std::size_t> next;
+		std::atomic<std::size_t> finishedHelpers;
+		std::atomic<bool> failed;
+		std::exception_ptr error;
+	} loop{};
+
+	auto body = [&loop, &func, count]() {
+		for (std::size_t i = loop.next++; i < count; i = loop.next++)
+		{
+			try
+			{
+				func(i);
+			}
+			catch (...)
+			{
+				if (!loop.failed.exchange(true))
+					loop.error = std::current_exception();
+				loop.next = count;
+			}
+		}
+	};
+
+	const std::size_t helperCount = std::min<std::size_t>(count - 1, m_threads.size());
+	for (std::size_t i = 0; i < helperCount; ++i)
+		Push(*m_queues[HomeQueue()], [&loop, &body]() {
+			body();
+			++loop.finishedHelpers;
+			});
+	body();
+
+	// helpers still queued only touch the loop to find it finished, running them here releases the loop sooner
+	const unsigned home = HomeQueue();
+	while (loop.finishedHelpers < helperCount)
+		if (!RunTask(home, false))
+			std::this_thread::yield();
+
+	if (loop.error)
+		std::rethrow_exception(loop.error);
+}
\ No newline at end of file